@@ -0,0 +1,52 @@
+#ifndef __CALIBRATION_INDEX_H__
+#define __CALIBRATION_INDEX_H__
+
+#include <string>
+#include <vector>
+#include <mutex>
+
+typedef std::vector<double> darray;
+typedef unsigned uint;
+
+// калибровки по диапазонам выстрелов: набор Calibration/N действует с выстрела N до следующего набора
+// (так наборы создает WriteCalibration), архив открывается один раз для списка наборов
+// и один раз для каждого набора при первом обращении к нему; если файл архива изменился
+// (набор записан другим процессом), индекс строится заново
+class CalibrationIndex
+{
+private:
+    struct Range
+    {
+        int first;
+        int last;
+        std::string set_name; // пустое - калибровка задана в коде
+        darray calibration;
+        bool loaded;
+    };
+
+    const std::string calibration_name;
+    std::string archive_name;
+    long long archive_mtime; // время изменения (нс) и размер архива при построении индекса
+    long long archive_size;
+    std::vector <Range> ranges; // по возрастанию first
+    bool loaded;
+    std::mutex mutex;
+
+    void load(const std::string &archive_name);
+    bool isArchiveChanged() const;
+    const darray &rangeCalibration(Range &range);
+    Range *findRange(int shot);
+
+public:
+    CalibrationIndex(const std::string &calibration_name) : calibration_name(calibration_name), archive_mtime(-1), archive_size(-1), loaded(false) {}
+    CalibrationIndex(const CalibrationIndex &) = delete;
+    CalibrationIndex &operator=(const CalibrationIndex &) = delete;
+
+    // false - выстрел вне известных диапазонов, калибровку нужно читать по выстрелу
+    bool find(const std::string &archive_name, int shot, darray &calibration);
+    // последний непустой набор, замена двух попыток чтения после GetLastShot
+    bool findLast(const std::string &archive_name, darray &calibration);
+    void invalidate(); // после записи калибровки
+};
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef __CAMPAIGN_RUNNER_H__
+#define __CAMPAIGN_RUNNER_H__
+
+#include <string>
+#include <sys/types.h>
+
+#include "ShotPipeline.h"
+
+// обработка большого диапазона выстрелов несколькими процессами,
+// у каждого процесса свой доступ к архиву
+class CampaignRunner
+{
+private:
+    struct Shard
+    {
+        uint first;
+        uint last;
+        std::string file_name;
+        uint attempts;
+    };
+
+    const ShotPipeline &pipeline;
+
+    pid_t startWorker(const std::string &executable, const std::string &input_file_name, const Shard &shard) const;
+    // выстрелы first..last, но не дальше последнего выстрела в архиве
+    bool createShotList(const ShotSettings &settings, uint first, uint last, uiarray &shots) const;
+
+public:
+    CampaignRunner(const ShotPipeline &pipeline) : pipeline(pipeline) {}
+
+    // выстрелы first..last в одном процессе, результат - набор результатов out_file_name,
+    // сырые данные из снимков snapshot_folder, если папка задана
+    int runWorker(const std::string &input_file_name, uint first, uint last, const std::string &out_file_name,
+                  const std::string &snapshot_folder="", bool useCache=false) const;
+
+    // сырые данные выстрелов first..last в снимки snapshot_folder, потом обработка идет без архива
+    int runSnapshots(const std::string &input_file_name, uint first, uint last, const std::string &snapshot_folder) const;
+
+    // подбор окон обработки сигналов по выстрелам first..last, результат - файл параметров out_file_name
+    int runTuning(const std::string &input_file_name, uint first, uint last, const std::string &out_file_name) const;
+
+    // диапазон делится на части по shard_size выстрелов, n_proc процессов executable --worker,
+    // упавшие части перезапускаются до max_attempts раз, готовые части с прошлого запуска не пересчитываются
+    int runCampaign(const std::string &executable, const std::string &input_file_name, uint first, uint last, uint n_proc,
+                    const std::string &out_file_name, uint shard_size=20, uint max_attempts=3) const;
+};
+
+#endif
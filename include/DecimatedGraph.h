@@ -0,0 +1,31 @@
+#ifndef __DECIMATED_GRAPH_H__
+#define __DECIMATED_GRAPH_H__
+
+#include <vector>
+#include <TGraphErrors.h>
+
+// график осциллограммы: при отрисовке в видимом диапазоне x остается не больше
+// двух точек (min и max) на пиксель pad, при увеличении масштаба точек становится больше
+class DecimatedGraph : public TGraphErrors
+{
+private:
+    bool decimation;
+
+    std::vector <double> dx; // точки для отрисовки, пересчитываются в каждом Paint
+    std::vector <double> dy;
+    std::vector <double> dex;
+    std::vector <double> dey;
+
+    void addPoint(int i);
+    bool decimate(double xmin, double xmax, int buckets);
+
+public:
+    explicit DecimatedGraph(int points) : TGraphErrors(points), decimation(false) {}
+
+    void setDecimation(bool decimation) { this->decimation = decimation; }
+    bool isDecimation() const { return decimation; }
+
+    void Paint(Option_t *chopt="") override;
+};
+
+#endif
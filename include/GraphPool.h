@@ -0,0 +1,40 @@
+#ifndef __GRAPH_POOL_H__
+#define __GRAPH_POOL_H__
+
+#include <map>
+#include <vector>
+#include <tuple>
+#include <TGraphErrors.h>
+#include <TH1D.h>
+#include <TMultiGraph.h>
+#include <THStack.h>
+#include <TPad.h>
+#include "DecimatedGraph.h"
+
+typedef unsigned uint;
+
+// графики и гистограммы старых mg/hs при перерисовке не удаляются, а используются снова,
+// в пуле только свободные объекты, поэтому закрытие окна пользователем ему не мешает
+class GraphPool
+{
+private:
+    static const uint MAX_FREE = 1024;
+
+    static std::map <uint, std::vector<DecimatedGraph*>> graphs; // ключ - число точек, Set не перевыделяет массивы
+    static std::map <std::tuple<uint, double, double>, std::vector<TH1D*>> hists;
+    static uint nFree;
+
+    static void put(DecimatedGraph *g);
+    static void put(TH1D *h);
+
+public:
+    static DecimatedGraph *getGraph(uint points); // прореживание выключено
+    static TH1D *getHist(uint nbins, double xmin, double xmax); // пустая, без gDirectory
+
+    // объекты переходят в пул, mg и hs после этого можно удалять
+    static void release(TMultiGraph *mg);
+    static void release(THStack *hs);
+    static void release(TVirtualPad *pad); // все mg и hs на pad и вложенных pad
+};
+
+#endif
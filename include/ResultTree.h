@@ -0,0 +1,58 @@
+#ifndef __RESULT_TREE_H__
+#define __RESULT_TREE_H__
+
+#include <string>
+#include <TFile.h>
+#include <TTree.h>
+
+#include "thomsonCounter/ResultCache.h"
+
+// результаты выстрелов в TTree "thomson", одна запись на (shot, sp, it),
+// файл дописывается, читается через RDataFrame (см. skripts/result_tree.C)
+class ResultTree
+{
+private:
+    const uint N_TIME_LIST;
+    const uint autosave_shots; // AutoSave через каждые autosave_shots выстрелов, 0 - только в close
+
+    TFile *file;
+    TTree *tree;
+    uint nShots;
+
+    // буферы веток
+    int shot;
+    uint sp;
+    uint it;
+    double time_point;
+    double x_position;
+    double energy;
+    double theta;
+    double Te;
+    double TeError;
+    double ne;
+    double neError;
+    double rmse;
+    double rmsePlus;
+    double rmseMinus;
+    darray *signals;
+    darray *signals_sigma;
+    darray *signalResult;
+    barray *work_signal;
+
+    template <class T>
+    void bind(const char *name, T *address, bool create);
+
+public:
+    ResultTree(uint N_TIME_LIST, uint autosave_shots=20);
+    ~ResultTree();
+    ResultTree(const ResultTree &) = delete;
+    ResultTree &operator=(const ResultTree &) = delete;
+
+    bool open(const std::string &file_name, bool append=true); // append=false - файл создается заново
+    bool add(int shot, const rarray &pages); // страницы it+sp*N_TIME_LIST
+    bool close();
+
+    bool isOpen() const { return tree != nullptr; }
+};
+
+#endif
@@ -0,0 +1,161 @@
+#ifndef __SHOT_PIPELINE_H__
+#define __SHOT_PIPELINE_H__
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <functional>
+#include <memory>
+
+#include <TString.h>
+#include <TFile.h>
+
+#include "thomsonCounter/SignalProcessing.h"
+#include "thomsonCounter/ThomsonCounter.h"
+#include "thomsonCounter/ResultCache.h"
+#include "thomsonCounter/ShotArena.h"
+#include "thomsonCounter/ShotSnapshot.h"
+#include "thomsonCounter/ParameterTuner.h"
+#include "thomsonCounter/ResponseTable.h"
+#include "thomsonCounter/ConvolutionTable.h"
+#include "CalibrationIndex.h"
+
+// настройки обработки, общие для всех выстрелов
+struct ShotSettings
+{
+    std::string archive_name;
+    std::string srf_file_folder;
+    std::string convolution_file_folder;
+    std::string cache_folder;
+    std::string snapshot_folder; // не пустая - сырые данные читаются из снимков выстрелов этого архива, если они есть; по умолчанию пустая
+
+    std::vector <parray> parametersArray;
+    std::vector <std::pair<double, double>> sigmaCoeff;
+    std::vector <barray> work_mask;
+
+    int selectionMethod;
+    bool count;
+    bool responseTables; // фит по таблицам отклика (Te, theta) из cache_folder вместо расчета спектров
+
+    darray calibrations; // не пустой - калибровки заданы вручную
+    uint64_t configHash; // 0 - кэш не используется
+
+    ShotSettings() : cache_folder("cache/"), selectionMethod(0), count(true), responseTables(false), configHash(0) {}
+};
+
+// данные одного выстрела, передаются между стадиями
+struct ShotItem
+{
+    int shot;
+    uint index;
+    uint64_t key;
+    bool cached;
+
+    darray calibrations;
+    darray time_points;
+    std::vector <sarray> t; // страницы it+sp*N_TIME_LIST
+    std::vector <sarray> U;
+    rarray pages; // результаты из кэша
+
+    // объекты принадлежат arena, удаляются вместе с ней
+    std::vector <SignalProcessing*> spArray;
+    std::vector <ThomsonCounter*> counterArray;
+    std::unique_ptr <ShotArena> arena;
+    ShotArenaPool *pool; // куда вернуть arena в clear, nullptr - удалить
+
+    ShotItem() : shot(0), index(0), key(0), cached(false), pool(nullptr) {}
+    void clear();
+};
+
+class ShotPipeline
+{
+private:
+    const char * const KUST_NAME;
+    const char * const CALIBRATION_NAME;
+    const double LAMBDA_REFERENCE;
+    const uint N_TIME_SIZE;
+    const uint UNUSEFULL;
+    const uint N_TIME_LIST;
+    const uint N_SPECTROMETERS;
+    const uint N_CHANNELS;
+    const uint NUMBER_ENERGY_SPECTROMETER;
+    const uint NUMBER_ENERGY_CHANNEL;
+    const uint N_SPECTROMETER_CALIBRATIONS;
+    const uint N_ADD_CALIBRATIONS=1;
+    const uint N_WORK_CHANNELS;
+
+    mutable ShotArenaPool arenaPool; // арены выстрелов, уже отданных consumer
+    mutable CalibrationIndex calibrationIndex;
+
+    // архив уже открыт
+    void readSignal(const char *kust, const char *signal_name, int shot, darray &t, darray &U, int timePoint, int timeList, const uint N_INFORM, const uint N_UNUSEFULL) const;
+    darray readTimePoints(TFile *file, int shot) const;
+
+    std::string srfFileName(const std::string &srf_file_folder, uint sp) const { return srf_file_folder+"SRF_Spectro-" + std::to_string(sp+1)+".dat"; }
+    std::string convolutionFileName(const std::string &convolution_file_folder, uint sp) const { return convolution_file_folder+"Convolution_Spectro-" + std::to_string(sp+1)+".dat"; }
+    std::string snapshotFileName(const std::string &snapshot_folder, int shot) const { return snapshot_folder+"shot_"+std::to_string(shot)+".tss"; }
+    bool readSnapshot(const ShotSettings &settings, ShotItem &item, darray &calibrations) const; // calibrations - калибровки снимка
+    bool isArchiveAvailable(const char *archive_name) const;
+
+public:
+    ShotPipeline(const char *KUST_NAME, const char *CALIBRATION_NAME,
+                double LAMBDA_REFERENCE, uint N_TIME_SIZE, uint UNUSEFULL,
+                uint N_TIME_LIST, uint N_SPECTROMETERS, uint N_CHANNELS,
+                uint NUMBER_ENERGY_SPECTROMETER, uint NUMBER_ENERGY_CHANNEL,
+                uint N_SPECTROMETER_CALIBRATIONS, uint N_WORK_CHANNELS);
+
+    uint getNTimeList() const { return N_TIME_LIST; }
+    TString getSignalName(uint nSpectrometer, uint nChannel) const;
+    int& getShot(int &shot) const;
+    void readDataFromArchive(const char* archive_name, const char* kust, const char *signal_name, int shot, darray &t, darray &U, int timePoint=-1, int timeList=11, const uint N_INFORM=2000, const uint N_UNUSEFULL=48) const;
+    darray readCalibration(const char *archive_name, const char *calibration_name, int shot) const;
+    darray getCalibration(const char *archive_name, int shot, bool extra=false) const;
+    void invalidateCalibrations() const { calibrationIndex.invalidate(); } // калибровки в архиве изменились
+    darray createTimePointsArray(const std::string &archive_name, int shot) const;
+
+    uint64_t configurationHash(const std::string &srf_file_folder, const std::string &convolution_file_folder, const std::string &error_file_name,
+                                const std::string &processing_parameters, const std::string *work_mask_string, int selectionMethod, bool count,
+                                bool responseTables=false) const;
+
+    // ключи входных данных: сигналов (архив, обработка сигналов) и таблиц SRF и свертки
+    uint64_t signalHash(const ShotSettings &settings, int shot) const;
+    uint64_t tablesHash(const ShotSettings &settings) const;
+
+    bool getline(std::ifstream &fin, std::string &line, char comment='#') const;
+    bool readFileInput( std::ifstream &fin,
+                        std::string &srf_file_folder, std::string &convolution_file_folder,
+                        std::string &raman_file_name, std::string &archive_file_name,
+                        std::string &error_file_name,
+                        std::string *work_mask_string,
+                        std::string &processing_parameters,
+                        int &type
+    ) const;
+    void readError(const char *file_name, std::vector<std::pair<double, double>> &sigmaCoeff) const;
+    std::vector <parray> readParametersToSignalProcessing(const std::string &file_name) const;
+    bool writeParametersToSignalProcessing(const std::string &file_name, const std::vector<parray> &parametersArray) const;
+    barray createWorkMask(const std::string &work_mask_string) const;
+
+    // настройки из основного файла для работы без GUI
+    bool createSettings(const std::string &file_name, ShotSettings &settings, bool useCache=false) const;
+    rarray createPages(const ShotItem &item) const;
+
+    // стадии обработки выстрела, работа с архивом только в readShot
+    void readShot(const ShotSettings &settings, ShotItem &item) const;
+    void processShot(const ShotSettings &settings, ShotItem &item) const;
+    void fitShot(const ShotSettings &settings, ShotItem &item) const;
+
+    void countShot(const ShotSettings &settings, int shot, ShotItem &item) const;
+    // сырые данные выстрелов из архива в снимки snapshot_folder для обработки без архива
+    bool exportSnapshots(const ShotSettings &settings, const uiarray &shots, const std::string &snapshot_folder) const;
+    // окна обработки сигналов каналов по сырым страницам выстрелов shots, стабильность сигнала к энергии лазера
+    bool tuneParameters(const ShotSettings &settings, const uiarray &shots, const TuneGrid &grid, std::vector<parray> &parametersArray) const;
+    // только fitShot с новыми калибровками и настройками фита, item.spArray и arena от прошлого счета выстрела
+    void refitShot(const ShotSettings &settings, ShotItem &item) const;
+
+    // стадии в отдельных потоках, между ними очереди глубиной queue_depth
+    // consumer вызывается в вызывающем потоке по порядку shots, false - остановить
+    // consumer может забрать item.arena вместе с объектами, иначе arena используется для следующих выстрелов
+    bool run(const ShotSettings &settings, const uiarray &shots, uint queue_depth, const std::function<bool(ShotItem &)> &consumer) const;
+};
+
+#endif
@@ -19,6 +19,25 @@
 #include <TPad.h>
 #include <vector>
 #include <string>
+#include <list>
+#include "GraphPool.h"
+#include <functional>
+
+// примитивы одной страницы слайдера, индекс массивов - номер pad
+struct TSCanvasPage
+{
+    bool built;
+    std::vector <TMultiGraph*> mgArray;
+    std::vector <THStack*> hsArray;
+    std::vector <TLegend*> legendArray;
+    std::vector <TLatex*> textArray;
+
+    TSCanvasPage() : built(false) {}
+    void clear();
+};
+
+// строит примитивы страницы nPoint слайдера
+typedef std::function<void(int nPoint, TSCanvasPage &page)> TSPageBuilder;
 
 class TSCanvas : public TCanvas
 {
@@ -42,12 +61,20 @@ private:
     std::vector <TLatex*> textArray;
     std::vector <std::string> titleArray;
 
+    TSPageBuilder pageBuilder;
+    std::vector <TSCanvasPage> pages;
+    std::list <int> lastPages; // построенные страницы, первая - последняя показанная
+    uint max_pages;
+
+    TSCanvasPage *getPage(int nPoint);
+    void drawPad(TMultiGraph *mg, THStack *hs, TLegend *leg, TLatex *tex);
+
 public:
     TSCanvas(TString name, TString title="", Int_t width=400, Int_t height=800, Int_t nx=1, Int_t ny=1,
             Int_t slider_points=11, Int_t start_slider_point=0, bool legend=true, bool grid=true, bool clear=true) : TCanvas(name, title, 1, 1, width, height),
                                                                         slider_points(slider_points), last_slider_point(start_slider_point),
                                                                         start_slider_point(start_slider_point),
-                                                                        nx(nx), ny(ny), grid(grid), clear(clear)
+                                                                        nx(nx), ny(ny), grid(grid), clear(clear), max_pages(0)
     {
         this->Divide(nx, ny);
         this->SetBit(kCanDelete);
@@ -113,6 +140,12 @@ public:
             hs->ResetBit(kCanDelete);
     }
 
+    // страница строится при первом показе, хранится не больше max_pages построенных страниц
+    void setPageBuilder(const TSPageBuilder &pageBuilder, uint max_pages=3);
+    // построенные страницы остаются, новые не строятся (данные для builder удалены)
+    void dropPageBuilder() { pageBuilder = nullptr; }
+    void drawPage(int nPoint);
+
     void setTitleArray(const std::vector <std::string> &titleArray)
     {
         this->titleArray = titleArray;
@@ -137,10 +170,16 @@ public:
         titleArray.clear();
         for (TMultiGraph *mg : mgArray)
             if (mg)
+            {
+                GraphPool::release(mg);
                 delete mg;
+            }
         for (THStack *hs : hsArray)
             if (hs)
+            {
+                GraphPool::release(hs);
                 delete hs;
+            }
         for (TLegend *leg : legendArray)
             if (leg)
                 delete leg;
@@ -152,6 +191,12 @@ public:
         hsArray.clear();
         legendArray.clear();
         textArray.clear();
+
+        pageBuilder = nullptr;
+        for (TSCanvasPage &page : pages)
+            page.clear();
+        pages.clear();
+        lastPages.clear();
     }
 
     TSlider * getSlider() const { return slider; }
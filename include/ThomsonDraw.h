@@ -20,6 +20,7 @@ class ThomsonDraw
 {
 private:
     static TGraph * createGraph(uint points, const double * const x, const double * const y, const uint color=1, const uint lineStyle=1, const uint lineWidth=2, const char *title="", const double * const errorX=nullptr, const double * const errorY=nullptr);
+    static TGraph * createWaveformGraph(uint points, const sample_t * const x, const sample_t * const y, const uint color=1, const uint lineStyle=1, const uint lineWidth=2, const char *title=""); // прореживается при отрисовке
     static TH1 * createHist(uint points, double xmin, double xmax, const double * const y, const uint color=1, const uint lineStyle=1, const uint lineWidth=2, const char *title="", const double * const error=nullptr);
     static TGraph * createSignalBox(double t1, double t2, double U, uint color=6, uint lineStyle=1, uint lineWidth=1);
     static TH1 * createHistStatistics(const darray &signal, double min, double max, uint nbins, const uint color=1, const uint lineStyle=1, const uint lineWidth=2, const char *title="");
@@ -30,6 +31,7 @@ public:
     static uint & Color(uint &color);
     static TLatex * createLatexText(TString text, double x, double y, uint color=1, double text_size=0.04, double text_align=22, bool draw=true);
     static TCanvas *createCanvas(const char *canvas_name, const char *title="", uint width=700, uint height=800, uint divideX=1, uint divideY=1);
+    static TCanvas *updateCanvas(const char *canvas_name, const char *title="", uint width=700, uint height=800, uint divideX=1, uint divideY=1); // очищает pad открытого canvas без пересоздания
     static TSCanvas *createSCanvas(const char *canvas_name, const char *title="", uint nSlider=11, uint start_point=0, uint width=700, uint height=800, uint divideX=1, uint divideY=1);
     static TMultiGraph *createMultiGraph(const char *mg_name, const char *mg_title);
     static THStack *createHStack(const char *hs_name, const char *hs_title);
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <list>
+#include <map>
 #include <vector>
 
 #include <TString.h>
@@ -21,6 +22,10 @@
 
 #include "thomsonCounter/SignalProcessing.h"
 #include "thomsonCounter/ThomsonCounter.h"
+#include "thomsonCounter/ShotStatistics.h"
+#include "ShotPipeline.h"
+#include "TSCanvas.h"
+#include "ThomsonSetup.h"
 
 enum class CountType {
     OneShot,
@@ -50,6 +55,8 @@ private:
     const uint N_WORK_CHANNELS;
     const uint N_FIRST_WORK_TIME_PAGE;
 
+    const ShotPipeline pipeline;
+    bool busy; // идет обработка нескольких выстрелов
 
     const uiarray color_map = {kYellow, 1,2,3,4, kOrange, 6,7, 209, 46, 11};
     const uint width = 700;
@@ -60,6 +67,8 @@ private:
     TApplication *app;
 
     TGTextEntry *mainFileTextEntry;
+    TGCheckButton *useResultCache;
+    TGCheckButton *useResponseTables;
     //TGNumberEntry *timeListNumber;
     TGCheckButton *writeResultTable;
 
@@ -141,6 +150,7 @@ private:
     std::vector <TGCheckButton*> checkButtonDrawTimeSetOfShots;
 
     TGCheckButton *cheakButtonCountThomsonSeveralShots;
+    TGNumberEntry *queueDepthEntry;
 
     uint N_SHOTS;
     uiarray shotArray;
@@ -150,7 +160,31 @@ private:
     std::vector<barray> work_mask;
 
     std::vector <SignalProcessing*> spArray;
-    std::vector <ThomsonCounter *> counterArray;
+    std::vector <ThomsonCounter *> counterArray; // для set of shots хранится выстрел 0 и один выбранный, остальные nullptr
+    std::vector <ShotArena*> arenas; // владельцы объектов spArray и counterArray, по одной на выстрел
+
+    ShotStatistics statistics;
+    ShotSettings shotSettings; // настройки последнего set of shots, для повторного счета выбранного выстрела
+    uint loadedShot; // номер в shotArray пересчитанного выстрела, 0 - нет
+    uint shotsVersion; // меняется при удалении объектов выстрелов, старые canvas больше не строят страницы
+
+    // от каких данных зависит canvas, перерисовываются только canvas с изменившимися данными
+    enum DrawData { DRAW_TABLES = 1, DRAW_SIGNALS = 2, DRAW_RESULTS = 4 };
+    struct DrawState
+    {
+        uint tables;
+        uint signals;
+        uint results;
+        std::string view; // выбранный выстрел и кнопки, от которых зависит canvas
+
+        bool operator==(const DrawState &state) const { return tables == state.tables && signals == state.signals && results == state.results && view == state.view; }
+    };
+    std::map <std::string, DrawState> drawStates;
+    uint64_t tablesKey; // хеш файлов SRF и свертки
+    uint64_t signalKey; // хеш входных данных сигналов выстрела OneShot, при совпадении пересчитывается только фит
+    uint tablesVersion;
+    uint signalsVersion;
+    uint resultsVersion;
 
     uint shotDiagnostic;
 
@@ -203,14 +237,8 @@ private:
     }
 
 
-    void meanThomsonData(uint N_SHOTS, darray & Te, darray & TeError, darray & ne, darray &neError, darray &xPositon, darray &time_points) const;
-
     bool shotNumberFromSetOfShots(uint &shot_number_from_set_of_shots, uint &shotDiagnostic, int shot);
 
-    bool getline(std::ifstream &fin, std::string &line, char comment='#') const;
-
-    void readError(const char *file_name, std::vector<std::pair<double, double>> &sigmaCoeff);
-
     std::vector <std::pair<double, double>> raman_parameters;
 
     void readRamanCrossSection(const char *raman_file_name);
@@ -218,21 +246,21 @@ private:
     void setDrawEnable(int signal, int thomson, int set_of_shots, int set_of_shots_thomson);
     void changeStatusText(TGTextEntry *entry, const char *text);
 
-    barray createWorkMask(const std::string &work_mask_string) const;
-
-    TString getSignalName(uint nSpectrometer, uint nChannel) const;
-    int& getShot(int &shot) const;
-    void readDataFromArchive(const char* archive_name, const char* kust, const char *signal_name, int shot, darray &t, darray &U, int timePoint=-1, int timeList=11, const uint N_INFORM=2000, const uint N_UNUSEFULL=48) const;
-    darray readCalibration(const char *archive_name, const char *calibration_name, int shot) const;
     bool isCalibrationNew(TFile *f, const char *calibration_name) const;
     bool writeCalibration(const char *archive_name, const char *calibration_name, darray &calibration) const;
-    void processingSignalsData(const char *archive_name, int shot, const std::vector<parray> &parametersArray, bool clearArray=true);
-    bool countThomson(const std::string &archive_name, const std::string &srf_file_folder, const std::string &convolution_file_folder, int shot, bool clearArray=true, int selectionMethod=0, uint shot_index=0, bool count=true);
     SignalProcessing * getSignalProcessing(uint it, uint sp, uint nShot=0) const;
     ThomsonCounter * getThomsonCounter(uint it, uint sp, uint nShot=0) const;
 
-    void clearSpArray();
-    void clearCounterArray();
+    void clearShots(bool keepSignals=false); // keepSignals - пересчитан только фит, сигналы выстрела прежние
+    void setTables(uint64_t key);
+    std::string drawView(uint nShot, const std::vector <TGCheckButton *> &buttonArray) const;
+    bool isCanvasActual(const char *canvas_name, uint data, const std::string &view); // false - canvas нужно перерисовать
+    // страницы canvas строятся при первом показе, addSpectrometer добавляет на страницу it примитивы спектрометра sp
+    void setSCanvasPages(TSCanvas *c, const std::function<void(uint it, uint sp, TSCanvasPage &page)> &addSpectrometer);
+    void addShotResult(ShotItem &item, bool keep=true);
+    bool loadShotFromSet(uint nShot);
+    barray timeMaskSetOfShots() const;
+    bool isBusy() const;
 
     void OpenFileDialogTemplate(TGTextEntry *textEntry);
 
@@ -240,36 +268,24 @@ private:
 
     bool checkButton(TGCheckButton *ch, bool lookEnable=true) const { return ch->IsDown() && (!lookEnable || ch->IsEnabled()); }
 
-    std::vector <parray> readParametersToSignalProcessing(const std::string &file_name) const;
-
     void writeResultTableToFile(const char *file_name) const;
 
-    void diactiveDiagnosticFrame(const char* text="press count");
+    void diactiveDiagnosticFrame(const char* text="press count", bool keepSignals=false);
 
     uiarray createArrayShots(const std::string &archive_name);
 
-    darray createTimePointsArray(const std::string &archive_name, int shot) const;
-
     void calibrateRaman(double P, double T, const darray &signalRaman_to_ERaman, const darray &lambda, const darray &SRF, darray &Ki) const;
 
-    bool readFileInput( std::ifstream &fin,
-                        std::string &srf_file_folder, std::string &convolution_file_folder,
-                        std::string &raman_file_name, std::string &archive_file_name,
-                        std::string &error_file_name, 
-                        std::string *work_mask_string,
-                        std::string &processing_parameters,
-                        int &type
-    ) const;
 
     uint getNumberActiveCheck(const std::vector <TGCheckButton *> &buttonArray) const;
 
 public:
     ThomsonGUI(const TGWindow *p, UInt_t width, UInt_t height, TApplication *app,
-                const char *KUST_NAME="Thomson", const char *CALIBRATION_NAME="thomson",
-                double LAMBDA_REFERENCE=1064., uint N_TIME_SIZE=1000., uint UNUSEFULL=48,
-                uint N_TIME_LIST=11, uint N_SPECTROMETERS=6, uint N_CHANNELS=8,
-                uint NUMBER_ENERGY_SPECTROMETER=2, uint NUMBER_ENERGY_CHANNEL=7,
-                uint N_SPECTROMETER_CALIBRATIONS=3, uint N_WORK_CHANNELS=6, uint N_FIRST_WORK_TIME_PAGE=1,
+                const char *KUST_NAME=THOMSON_KUST_NAME, const char *CALIBRATION_NAME=THOMSON_CALIBRATION_NAME,
+                double LAMBDA_REFERENCE=THOMSON_LAMBDA_REFERENCE, uint N_TIME_SIZE=THOMSON_N_TIME_SIZE, uint UNUSEFULL=THOMSON_UNUSEFULL,
+                uint N_TIME_LIST=THOMSON_N_TIME_LIST, uint N_SPECTROMETERS=THOMSON_N_SPECTROMETERS, uint N_CHANNELS=THOMSON_N_CHANNELS,
+                uint NUMBER_ENERGY_SPECTROMETER=THOMSON_NUMBER_ENERGY_SPECTROMETER, uint NUMBER_ENERGY_CHANNEL=THOMSON_NUMBER_ENERGY_CHANNEL,
+                uint N_SPECTROMETER_CALIBRATIONS=THOMSON_N_SPECTROMETER_CALIBRATIONS, uint N_WORK_CHANNELS=THOMSON_N_WORK_CHANNELS, uint N_FIRST_WORK_TIME_PAGE=1,
                 Long_t time_ms=10000
     );
 
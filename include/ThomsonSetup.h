@@ -0,0 +1,24 @@
+#ifndef __THOMSON_SETUP_H__
+#define __THOMSON_SETUP_H__
+
+// установка томсоновского рассеяния: имена в архиве и размеры данных, общие для GUI и обработки без GUI
+#define THOMSON_KUST_NAME "Thomson"
+#define THOMSON_CALIBRATION_NAME "thomson"
+#define THOMSON_LAMBDA_REFERENCE 1064.
+#define THOMSON_N_TIME_SIZE 1000
+#define THOMSON_UNUSEFULL 48
+#define THOMSON_N_TIME_LIST 11
+#define THOMSON_N_SPECTROMETERS 6
+#define THOMSON_N_CHANNELS 8
+#define THOMSON_NUMBER_ENERGY_SPECTROMETER 2
+#define THOMSON_NUMBER_ENERGY_CHANNEL 7
+#define THOMSON_N_SPECTROMETER_CALIBRATIONS 4
+#define THOMSON_N_WORK_CHANNELS 6
+
+// аргументы конструкторов ShotPipeline и ThomsonGUI от KUST_NAME до N_WORK_CHANNELS
+#define THOMSON_SETUP THOMSON_KUST_NAME, THOMSON_CALIBRATION_NAME, THOMSON_LAMBDA_REFERENCE, THOMSON_N_TIME_SIZE, THOMSON_UNUSEFULL, \
+                      THOMSON_N_TIME_LIST, THOMSON_N_SPECTROMETERS, THOMSON_N_CHANNELS, \
+                      THOMSON_NUMBER_ENERGY_SPECTROMETER, THOMSON_NUMBER_ENERGY_CHANNEL, \
+                      THOMSON_N_SPECTROMETER_CALIBRATIONS, THOMSON_N_WORK_CHANNELS
+
+#endif
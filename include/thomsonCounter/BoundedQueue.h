@@ -0,0 +1,56 @@
+#ifndef __BOUNDED_QUEUE_H__
+#define __BOUNDED_QUEUE_H__
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+// очередь между стадиями конвейера, push блокируется пока очередь заполнена
+template <class T>
+class BoundedQueue
+{
+private:
+    std::deque<T> queue;
+    const size_t capacity;
+    bool closed;
+
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+
+public:
+    explicit BoundedQueue(size_t capacity) : capacity(capacity == 0 ? 1 : capacity), closed(false) {}
+
+    bool push(T &&value) // false - очередь закрыта, value не изменяется
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_full.wait(lock, [this]() { return closed || queue.size() < capacity; });
+        if (closed)
+            return false;
+        queue.push_back(std::move(value));
+        not_empty.notify_one();
+        return true;
+    }
+
+    bool pop(T &value) // false - очередь закрыта и пуста
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_empty.wait(lock, [this]() { return closed || !queue.empty(); });
+        if (queue.empty())
+            return false;
+        value = std::move(queue.front());
+        queue.pop_front();
+        not_full.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        not_empty.notify_all();
+        not_full.notify_all();
+    }
+};
+
+#endif
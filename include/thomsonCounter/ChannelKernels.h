@@ -0,0 +1,86 @@
+#ifndef __CHANNEL_KERNELS_H__
+#define __CHANNEL_KERNELS_H__
+
+#include <array>
+#include <vector>
+#include <cmath>
+#include <limits>
+
+typedef unsigned uint;
+typedef std::vector<double> darray;
+typedef std::vector<bool> barray;
+
+// ядра по парам каналов для числа каналов N, известного при компиляции:
+// массивы пар на стеке, циклы по парам с постоянными границами раскрываются компилятором
+
+// начальное приближение Te по таблице свертки SCount[it+ch*N_TEMPERATURE], как ThomsonCounter::findTZeroApproximation
+template <uint N>
+double findTZeroApproximationFixed(const darray &signal, const barray &channel_work, const darray &SCount, uint N_TEMPERATURE, double T0, double dT)
+{
+    const double maxD = std::numeric_limits<double>::max();
+
+    // отношения сигналов и маска пар не зависят от температуры
+    std::array <double, N*N> ratio;
+    std::array <bool, N*N> use;
+    for (uint ch2 = 0; ch2 < N; ch2++)
+    {
+        for (uint ch1 = 0; ch1 < N; ch1++)
+        {
+            use[ch1+ch2*N] = channel_work[ch1] && channel_work[ch2];
+            ratio[ch1+ch2*N] = use[ch1+ch2*N] ? signal[ch2]/signal[ch1] : 0.;
+        }
+    }
+
+    double Te0 = T0;
+    double L_2_min = maxD;
+    for (uint it = 0; it < N_TEMPERATURE; it++)
+    {
+        std::array <double, N> S;
+        for (uint ch = 0; ch < N; ch++)
+            S[ch] = SCount[it+ch*N_TEMPERATURE];
+
+        // порядок суммы тот же, что в общем варианте
+        double L2 = 0.;
+        for (uint ch2 = 0; ch2 < N; ch2++)
+        {
+            for (uint ch1 = 0; ch1 < N; ch1++)
+            {
+                if (!use[ch1+ch2*N])
+                    continue;
+                double delta = ratio[ch1+ch2*N] - S[ch2]/S[ch1];
+                L2 += delta*delta;
+            }
+        }
+
+        // nan или inf не исчезают из суммы, проверка после цикла как break в общем варианте
+        if (std::isnan(L2) || std::isinf(L2))
+            L2 = maxD;
+
+        if (L2 < L_2_min)
+        {
+            L_2_min = L2;
+            Te0 = T0 + it*dT;
+        }
+    }
+
+    return Te0;
+}
+
+// производные отношений сигналов по Te для пар ch1 < ch2 в порядке ThomsonCounter::createChannelsNumberArray,
+// Q1, Q2 - свертки каналов при T и T+deltaT, как в ThomsonCounter::devFij
+template <uint N>
+void devFPairsFixed(const std::array<double, N> &Q1, const std::array<double, N> &Q2, double deltaT, std::array<double, N*(N-1)/2> &dev)
+{
+    uint k = 0;
+    for (uint ch2 = 0; ch2 < N; ch2++)
+    {
+        for (uint ch1 = 0; ch1 < ch2; ch1++)
+        {
+            double dev_ratio_count = Q2[ch2] / Q2[ch1];
+            dev_ratio_count -= Q1[ch2] / Q1[ch1];
+            dev[k++] = dev_ratio_count / deltaT;
+        }
+    }
+}
+
+#endif
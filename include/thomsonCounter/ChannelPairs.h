@@ -0,0 +1,41 @@
+#ifndef __CHANNEL_PAIRS_H__
+#define __CHANNEL_PAIRS_H__
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+typedef unsigned uint;
+
+// общий канал двух пар: сторона в первой и второй паре (0 - ch1, 1 - ch2),
+// -1 - общих каналов нет, 2 - это одна и та же пара
+struct PairShare
+{
+    int8_t first;
+    int8_t second;
+};
+
+// пары каналов ch1 < ch2 и их общие каналы, один объект на все счетчики с тем же числом каналов
+class ChannelPairs
+{
+private:
+    uint N_CHANNELS;
+    uint N_RATIO;
+    std::vector <std::pair<uint, uint>> pairs; // ch2 по возрастанию, внутри ch1 по возрастанию
+    std::vector <int> index; // [ch1+ch2*N_CHANNELS] -> номер пары, -1 если ch1 >= ch2
+    std::vector <PairShare> share; // [k+ks*N_RATIO]
+
+    ChannelPairs(uint N_CHANNELS);
+
+public:
+    static const ChannelPairs &get(uint N_CHANNELS); // создается при первом запросе, потокобезопасно
+
+    uint getNChannels() const { return N_CHANNELS; }
+    uint getNRatio() const { return N_RATIO; }
+    const std::vector <std::pair<uint, uint>> &getPairs() const { return pairs; }
+    const std::pair<uint, uint> &getPair(uint k) const { return pairs[k]; }
+    int find(uint ch1, uint ch2) const { return ch1 < N_CHANNELS && ch2 < N_CHANNELS ? index[ch1+ch2*N_CHANNELS] : -1; }
+    PairShare getShare(uint k, uint ks) const { return share[k+ks*N_RATIO]; }
+};
+
+#endif
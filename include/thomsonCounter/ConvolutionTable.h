@@ -0,0 +1,56 @@
+#ifndef __CONVOLUTION_TABLE_H__
+#define __CONVOLUTION_TABLE_H__
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+
+typedef std::vector<double> darray;
+typedef unsigned uint;
+
+// равномерная сетка Te, как в файлах Convolution_Spectro-N.dat
+struct ConvolutionGrid
+{
+    double T0; // эВ
+    double dT;
+    uint N_T;
+
+    ConvolutionGrid() : T0(5.), dT(5.), N_T(2000) {}
+};
+
+// свертки SRF каналов со спектром SRelative при одном theta, замена внешнему файлу свертки
+class ConvolutionTable
+{
+private:
+    ConvolutionGrid grid;
+    uint N_CHANNELS;
+    double theta;
+    double lambda_reference;
+    darray SCount; // [it+ch*N_T], как readSpectrumFromT
+
+public:
+    ConvolutionTable() : N_CHANNELS(0), theta(0.), lambda_reference(0.) {}
+
+    // threads = 0 - по числу ядер, узлы Te делятся между потоками
+    bool build(const darray &SRF, uint N_CHANNELS, uint N_LAMBDA, double lMin, double lMax, double dl, double theta, double lambda_reference,
+               const ConvolutionGrid &grid=ConvolutionGrid(), uint threads=0);
+
+    bool write(const std::string &file_name, uint64_t key) const;
+    bool read(const std::string &file_name, uint64_t key); // false если нет файла или ключ не совпал
+
+    const ConvolutionGrid &getGrid() const { return grid; }
+    uint getNChannels() const { return N_CHANNELS; }
+    double getTheta() const { return theta; }
+    const darray &getSCount() const { return SCount; }
+
+    // таблица для SRF и theta, на диске в cache_folder (пустая строка - без диска),
+    // ключ по содержимому SRF, theta, lambda_reference и сетке - при их изменении таблица строится заново;
+    // в памяти и на диске хранится ограниченное число таблиц, давно не использованные удаляются
+    static std::shared_ptr<const ConvolutionTable> get(const std::string &srf_file_name, uint N_CHANNELS, double theta, double lambda_reference,
+                                                       const std::string &cache_folder, const ConvolutionGrid &grid=ConvolutionGrid());
+};
+
+std::string convolutionCacheFileName(const std::string &cache_folder, const std::string &srf_file_name, uint64_t key);
+
+#endif
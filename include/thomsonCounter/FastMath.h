@@ -0,0 +1,88 @@
+#ifndef __FAST_MATH_H__
+#define __FAST_MATH_H__
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+typedef unsigned uint;
+
+// точность exp в спектральных ядрах (SRelative, SClassic, countSArray)
+enum ExpTier
+{
+    EXP_STD=0, // std::exp
+    EXP_1E12=12, // относительная ошибка < 1e-12
+    EXP_1E7=7 // относительная ошибка < 1e-7
+};
+
+#ifndef THOMSON_EXP_TIER
+#define THOMSON_EXP_TIER 0 // по умолчанию, задается при сборке (cmake -DTHOMSON_EXP_TIER=12)
+#endif
+
+ExpTier getExpTier();
+void setExpTier(ExpTier tier); // для всех потоков, влияет на следующие вызовы ядер
+
+constexpr double invFactorial(uint k) { return k <= 1 ? 1. : invFactorial(k-1) / k; }
+
+// ряд Тейлора exp(r) по схеме Горнера, раскрывается при компиляции
+template <uint K, uint DEGREE>
+struct ExpSeries
+{
+    static double eval(double r) { return invFactorial(K) + r*ExpSeries<K+1, DEGREE>::eval(r); }
+};
+
+template <uint DEGREE>
+struct ExpSeries<DEGREE, DEGREE>
+{
+    static double eval(double) { return invFactorial(DEGREE); }
+};
+
+// 2^n для целого n в double, |n| < 1023
+inline double exp2Int(double n)
+{
+    const double SHIFT = 6755399441055744.0; // 1.5*2^52, после сложения в младших битах мантиссы целое n
+    double t = n + SHIFT;
+    uint64_t bits, shift_bits;
+    std::memcpy(&bits, &t, sizeof(bits));
+    std::memcpy(&shift_bits, &SHIFT, sizeof(shift_bits));
+    uint64_t scale_bits = (bits - shift_bits + 1023) << 52;
+    double scale;
+    std::memcpy(&scale, &scale_bits, sizeof(scale));
+    return scale;
+}
+
+// exp без ветвлений и сравнений, цикл с ним векторизуется: x = n*ln2 + r, |r| <= ln2/2, exp(r) рядом Тейлора степени DEGREE,
+// 2^n двумя множителями, поэтому денормализованные результаты и 0 при x < -745 как у std::exp; x > 709.7 дает exp(709.7)
+template <uint DEGREE>
+inline double fastExp(double x)
+{
+    const double LOG2E = 1.4426950408889634;
+    const double LN2_HI = 6.93147180369123816490e-01; // ln2 = LN2_HI + LN2_LO, n*LN2_HI точно
+    const double LN2_LO = 1.90821492927058770002e-10;
+    const double SHIFT = 6755399441055744.0;
+    static_assert(DEGREE >= 1 && DEGREE <= 16, "степень ряда 1..16");
+
+    double xc = std::min(std::max(x, -746.), 709.7);
+    double n = (xc*LOG2E + SHIFT) - SHIFT; // ближайшее целое
+    double r = (xc - n*LN2_HI) - n*LN2_LO;
+    double n1 = (n*0.5 + SHIFT) - SHIFT;
+
+    return ExpSeries<0, DEGREE>::eval(r) * exp2Int(n1) * exp2Int(n - n1);
+}
+
+// степени ряда для уровней точности, ошибка ряда при |r| = ln2/2: 11 - 4e-15, 7 - 5e-9
+#define EXP_1E12_DEGREE 11
+#define EXP_1E7_DEGREE 7
+
+inline double fastExp(double x, ExpTier tier)
+{
+    switch (tier)
+    {
+        case EXP_1E12: return fastExp<EXP_1E12_DEGREE>(x);
+        case EXP_1E7: return fastExp<EXP_1E7_DEGREE>(x);
+        default: return exp(x);
+    }
+}
+
+#endif
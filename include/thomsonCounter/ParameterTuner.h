@@ -0,0 +1,55 @@
+#ifndef __PARAMETER_TUNER_H__
+#define __PARAMETER_TUNER_H__
+
+#include <vector>
+#include <utility>
+#include "SignalProcessing.h"
+
+// сетка подбора окон обработки сигнала канала
+struct TuneGrid
+{
+    uint radius; // signal_point_start и point_integrate_start в +-radius точек от текущих
+    uint stride;
+    uiarray signalSteps; // signal_point_step
+    uiarray zeroSteps; // step_from_start_zero_line
+
+    TuneGrid() : radius(40), stride(2), signalSteps({1, 2, 5, 10, 20, 40}), zeroSteps({20, 50, 100, 200}) {}
+};
+
+struct TuneResult
+{
+    SignalProcessingParameters parameters;
+    double score; // меньше - лучше
+    double startScore; // у исходных параметров
+    uint settings; // сколько наборов проверено
+};
+
+// подбор окон нулевой линии, интегрирования и сигнала одного канала по набору страниц:
+// по каждой странице один раз считаются префиксные суммы U, интеграла и времени,
+// после этого сигнал для любых окон считается за O(1) на страницу,
+// массивы хранятся по точкам, страницы подряд - цикл по страницам векторизуется
+class ParameterTuner
+{
+private:
+    uint tSize;
+    uint nSamples;
+    uint added;
+
+    darray P; // [i*nSamples+k] сумма U по точкам < i
+    darray Q; // сумма интеграла без нулевой линии
+    darray C; // сумма времени
+    darray energy;
+
+public:
+    ParameterTuner(uint tSize, uint nSamples);
+
+    // осциллограмма канала одной страницы и энергия лазера для нее
+    void addSample(const sample_t *t, const sample_t *U, double energy);
+    uint getNSamples() const { return added; }
+
+    // относительная погрешность сигнала: разброс вокруг S = a*E и sigma по sigmaCoeff к среднему сигналу
+    double score(const SignalProcessingParameters &parameters, const std::pair<double, double> &sigmaCoeff) const;
+    TuneResult tune(const SignalProcessingParameters &start, const std::pair<double, double> &sigmaCoeff, const TuneGrid &grid=TuneGrid()) const;
+};
+
+#endif
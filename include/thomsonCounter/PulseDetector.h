@@ -0,0 +1,57 @@
+#ifndef __PULSE_DETECTOR_H__
+#define __PULSE_DETECTOR_H__
+
+#include <string>
+#include <vector>
+#include "TimeAxis.h"
+
+enum DetectorType
+{
+    DETECTOR_THRESHOLD=0, // порог, число точек фронтов и наклон интеграла (checkSignal)
+    DETECTOR_MATCHED=1 // согласованный фильтр с шаблоном импульса канала
+};
+
+// форма импульса канала с шагом оцифровки, максимум формы равен 1
+class PulseTemplate
+{
+private:
+    darray shape;
+    double energy; // сумма квадратов формы
+    uint peak; // точка максимума
+    std::string name; // как задан в файле параметров
+
+public:
+    PulseTemplate(const darray &shape);
+
+    static PulseTemplate gaussian(double width); // width - ширина на полувысоте в точках
+
+    const darray &getShape() const { return shape; }
+    double getEnergy() const { return energy; }
+    uint getPeak() const { return peak; }
+    uint size() const { return shape.size(); }
+    const std::string &getName() const { return name; }
+    void setName(const std::string &name) { this->name = name; }
+};
+
+// шаблон из текстового файла, одно значение в строке
+bool readPulseTemplate(const std::string &file_name, darray &shape);
+
+struct PulseMatch
+{
+    double snr; // максимум свертки к шуму свертки
+    double time; // время максимума импульса
+    double amplitude; // амплитуда шаблона, лучше всего описывающая сигнал
+    double noise; // шум отсчетов
+
+    uint start; // первая точка шаблона в максимуме свертки
+
+    PulseMatch() : snr(0.), time(0.), amplitude(0.), noise(0.), start(0) {}
+};
+
+// свертка сигнала канала (без нулевой линии) с шаблоном,
+// шум оценивается по медиане модулей разностей соседних точек, поэтому импульс и дрейф нулевой линии на него почти не влияют;
+// если медиана 0 (квантованный тихий канал) - по СКО разностей, снизу ограничен шумом квантования,
+// buffer - рабочая память, сохраняется между вызовами
+PulseMatch matchPulse(const sample_t *U, uint n, const PulseTemplate &pulse, const TimeAxis &timeAxis, uint channel, darray &buffer);
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef __RESPONSE_TABLE_H__
+#define __RESPONSE_TABLE_H__
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <cmath>
+
+typedef std::vector<double> darray;
+typedef unsigned uint;
+
+// сетка таблицы: Te равномерно по ln Te, theta равномерно, в каждой оси не меньше 4 узлов
+struct ResponseGrid
+{
+    double TMin; // эВ
+    double TMax;
+    uint N_T;
+    double thetaMin; // рад
+    double thetaMax;
+    uint N_THETA;
+
+    ResponseGrid() : TMin(1.), TMax(20000.), N_T(512), thetaMin(90./180.*M_PI), thetaMax(125./180.*M_PI), N_THETA(36) {}
+};
+
+// свертки SRF каналов со спектром рассеяния (SRelative, амплитуда SNorma) в узлах (Te, theta),
+// между узлами бикубическая интерполяция Catmull-Rom, поэтому любое theta сетки считается без спектров
+class ResponseTable
+{
+private:
+    ResponseGrid grid;
+    uint N_CHANNELS;
+    double lambda_reference;
+    double dx; // шаг по ln Te
+    double dtheta;
+    darray Q; // [it+ith*N_T+ch*N_T*N_THETA]
+
+    struct Stencil
+    {
+        uint first; // первый из 4 узлов
+        double w[4];
+        double dw[4]; // производная весов по номеру узла
+    };
+
+    Stencil stencil(double x, uint n) const; // x - координата в шагах сетки от первого узла
+    void slice(const Stencil &sy, uint ch, double *S) const; // канал ch во всех узлах Te
+    bool setGrid(const ResponseGrid &grid);
+
+public:
+    ResponseTable() : N_CHANNELS(0), lambda_reference(0.), dx(0.), dtheta(0.) {}
+
+    // threads = 0 - по числу ядер, строки theta считаются параллельно
+    bool build(const darray &SRF, uint N_CHANNELS, uint N_LAMBDA, double lMin, double lMax, double dl, double lambda_reference,
+               const ResponseGrid &grid=ResponseGrid(), uint threads=0);
+
+    bool write(const std::string &file_name, uint64_t key) const;
+    bool read(const std::string &file_name, uint64_t key); // false если нет файла или ключ не совпал
+
+    bool contains(double Te, double theta) const;
+
+    // свертки всех каналов при (Te, theta), dQ - производная по Te
+    void count(double Te, double theta, double *Q, double *dQ=nullptr) const;
+    // все каналы в узлах Te при theta, [it+ch*N_T] как свертка из файла
+    void slice(double theta, darray &S) const;
+    // решение Q_ch2/Q_ch1 = ratio, из пересечений на узлах выбирается ближайшее к Te0
+    double solveRatio(uint ch1, uint ch2, double ratio, double theta, double Te0, double epsilon, uint iter_limit, bool &success) const;
+
+    uint getNChannels() const { return N_CHANNELS; }
+    uint getNT() const { return grid.N_T; }
+    double getNodeT(uint it) const { return exp(log(grid.TMin) + it*dx); }
+    const ResponseGrid &getGrid() const { return grid; }
+    double getLambdaReference() const { return lambda_reference; }
+
+    // таблица для файла SRF, одна на процесс, на диске в cache_folder (пустая строка - без диска)
+    static std::shared_ptr<const ResponseTable> get(const std::string &srf_file_name, uint N_CHANNELS, double lambda_reference,
+                                                    const std::string &cache_folder, const ResponseGrid &grid=ResponseGrid());
+};
+
+std::string responseFileName(const std::string &cache_folder, const std::string &srf_file_name);
+
+#endif
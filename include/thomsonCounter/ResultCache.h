@@ -0,0 +1,64 @@
+#ifndef __RESULT_CACHE_H__
+#define __RESULT_CACHE_H__
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <iostream>
+
+typedef unsigned uint;
+typedef std::vector<double> darray;
+typedef std::vector<bool> barray;
+
+// результат обработки одной страницы (sp, it) выстрела
+struct PageResult
+{
+    darray signals;
+    darray signals_sigma;
+    barray work_signal;
+    double coeff_to_energy;
+
+    double theta;
+    darray Ki;
+    double energy;
+    double time_point;
+    double x_position;
+
+    double Te;
+    double TeError;
+    double ne;
+    double neError;
+    double rmse;
+    double rmsePlus;
+    double rmseMinus;
+
+    darray signalResult;
+    darray signalResultPlus;
+    darray signalResultMinus;
+
+    PageResult() : coeff_to_energy(1.), theta(0.), energy(0.), time_point(0.), x_position(0.),
+                   Te(0.), TeError(0.), ne(0.), neError(0.), rmse(0.), rmsePlus(0.), rmseMinus(0.)
+    {}
+};
+
+typedef std::vector<PageResult> rarray;
+
+// FNV-1a хеши для ключа кэша
+uint64_t hashBytes(const void *data, size_t size, uint64_t hash=14695981039346656037ULL);
+uint64_t hashString(const std::string &str, uint64_t hash=14695981039346656037ULL);
+uint64_t hashArray(const darray &array, uint64_t hash=14695981039346656037ULL);
+uint64_t hashFile(const std::string &file_name, uint64_t hash=14695981039346656037ULL); // если файла нет хешируется только имя
+
+// запись одной страницы в двоичном виде, общая для кэша и набора результатов
+void writePage(std::ostream &fout, const PageResult &page);
+bool readPage(std::istream &fin, PageResult &page);
+
+// ключ кэша выстрела: настройки счета, архив (номера выстрелов в разных архивах совпадают) и калибровки
+uint64_t shotCacheKey(uint64_t configHash, const std::string &archive_name, const darray &calibrations);
+
+std::string cacheFileName(const std::string &cache_folder, int shot);
+
+bool writeShotCache(const std::string &cache_folder, int shot, uint64_t key, const rarray &pages);
+bool readShotCache(const std::string &cache_folder, int shot, uint64_t key, rarray &pages); // false если нет файла или ключ не совпал
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef __RESULT_SET_H__
+#define __RESULT_SET_H__
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include <functional>
+
+#include "ResultCache.h"
+
+// результаты многих выстрелов в одном файле, индекс (shot, смещение) записан в конце
+class ResultSetWriter
+{
+private:
+    std::ofstream fout;
+    std::string file_name;
+    std::string temp_name;
+    std::vector <std::pair<int32_t, uint64_t>> index;
+
+public:
+    ResultSetWriter() {}
+    ~ResultSetWriter();
+
+    bool open(const std::string &file_name);
+    bool add(int shot, const rarray &pages);
+    bool close(); // записывает индекс, файл появляется только после close
+
+    uint size() const { return index.size(); }
+};
+
+bool readResultSetIndex(const std::string &file_name, std::vector <std::pair<int32_t, uint64_t>> &index); // false если файл не полный
+bool readResultSetShot(const std::string &file_name, int shot, rarray &pages);
+// все выстрелы по порядку индекса за одно открытие файла, consumer вернул false - остановить
+bool readResultSet(const std::string &file_name, const std::function<bool(int shot, const rarray &pages)> &consumer);
+
+// объединение в один файл по возрастанию shot, повторы берутся из первого файла
+bool mergeResultSets(const std::vector <std::string> &file_names, const std::string &out_file_name);
+
+#endif
@@ -10,4 +10,45 @@ typedef unsigned uint;
 bool readSRF(std::string filename, darray &SRF, double &lMin, double &lMax, double &dl,
      uint &N_LAMBDA, uint N_CHANNELS);
 
+#define SRF_BAND_TOLERANCE 1e-6 // доля максимума канала, края SRF ниже нее отбрасываются
+
+// полоса канала по индексам длины волны [first, first+size)
+struct SRFBand
+{
+    uint first;
+    uint size; // 0 - канал без SRF
+    uint offset; // начало полосы в SparseSRF::values
+
+    uint last() const { return first+size-1; }
+};
+
+// SRF каналов только в полосе пропускания, спектр нужен только в полосе, а не на всей сетке N_LAMBDA
+class SparseSRF
+{
+private:
+    std::vector <SRFBand> bands;
+    darray values; // полосы каналов подряд, умножены на веса трапеций и dl, как в convolution
+    SRFBand all; // объединение полос всех каналов
+    uint N_LAMBDA;
+    double lMin;
+    double dl; // (lMax-lMin)/(N_LAMBDA-1)
+
+public:
+    SparseSRF() : all{0, 0, 0}, N_LAMBDA(0), lMin(0.), dl(0.) {}
+
+    // SRF[ch*N_LAMBDA+i] как в readSRF
+    void assign(const darray &SRF, uint N_CHANNELS, uint N_LAMBDA, double lMin, double lMax, double tolerance=SRF_BAND_TOLERANCE);
+
+    uint getNChannels() const { return bands.size(); }
+    const SRFBand &getBand(uint ch) const { return bands[ch]; }
+    const SRFBand &getUnion() const { return all; }
+    SRFBand getUnion(uint ch1, uint ch2) const;
+    double getLambda(uint i) const { return lMin + i*dl; }
+    double getDl() const { return dl; }
+
+    // свертка канала со спектром S, посчитанным в точках band.first.. полосы band, содержащей полосу канала;
+    // совпадает с convolution по всей сетке с точностью до отброшенных краев
+    double convolution(uint ch, const double *S, const SRFBand &band) const;
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,69 @@
+#ifndef __SHOT_ARENA_H__
+#define __SHOT_ARENA_H__
+
+#include <vector>
+#include <mutex>
+#include <utility>
+#include "SignalProcessing.h"
+#include "ThomsonCounter.h"
+
+// объекты обработки одного выстрела, выделяются подряд и освобождаются одним reset,
+// после reset объекты используются для следующего выстрела без выделения памяти
+class ShotArena
+{
+private:
+    std::vector <SignalProcessing*> spStorage;
+    std::vector <ThomsonCounter*> counterStorage;
+    uint spUsed;
+    uint counterUsed;
+
+public:
+    ShotArena() : spUsed(0), counterUsed(0) {}
+    ~ShotArena();
+    ShotArena(const ShotArena &) = delete;
+    ShotArena &operator=(const ShotArena &) = delete;
+
+    // аргументы как у конструкторов SignalProcessing и ThomsonCounter
+    template <class... Args>
+    SignalProcessing *createSignalProcessing(Args&&... args)
+    {
+        if (spUsed < spStorage.size())
+            spStorage[spUsed]->assign(std::forward<Args>(args)...);
+        else
+            spStorage.push_back(new SignalProcessing(std::forward<Args>(args)...));
+        return spStorage[spUsed++];
+    }
+
+    template <class... Args>
+    ThomsonCounter *createThomsonCounter(Args&&... args)
+    {
+        if (counterUsed < counterStorage.size())
+            counterStorage[counterUsed]->assign(std::forward<Args>(args)...);
+        else
+            counterStorage.push_back(new ThomsonCounter(std::forward<Args>(args)...));
+        return counterStorage[counterUsed++];
+    }
+
+    void reset() { spUsed = 0; counterUsed = 0; } // указатели, выданные до reset, больше не принадлежат выстрелу
+    void resetThomsonCounters() { counterUsed = 0; } // для повторного фита, SignalProcessing остаются у выстрела
+};
+
+// свободные арены, общие для потоков конвейера
+class ShotArenaPool
+{
+private:
+    std::vector <ShotArena*> arenas;
+    std::mutex mutex;
+
+public:
+    ShotArenaPool() {}
+    ~ShotArenaPool() { clear(); }
+    ShotArenaPool(const ShotArenaPool &) = delete;
+    ShotArenaPool &operator=(const ShotArenaPool &) = delete;
+
+    ShotArena *acquire();
+    void release(ShotArena *arena);
+    void clear(); // удалить свободные арены, например после смены файлов SRF
+};
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef __SHOT_SNAPSHOT_H__
+#define __SHOT_SNAPSHOT_H__
+
+#include <string>
+#include <vector>
+#include "SignalProcessing.h"
+
+// сырые данные выстрела для повторной обработки без архива
+struct ShotSnapshot
+{
+    int shot;
+    std::string archive_name; // архив, из которого прочитан выстрел
+    uint N_TIME_LIST;
+    uint N_SPECTROMETERS;
+    uint N_CHANNELS;
+    uint N_TIME_SIZE;
+
+    darray calibrations; // калибровки на момент записи, используются только без доступа к архиву
+    darray time_points; // найдены по опорному сигналу MSE ts_ref2
+    std::vector <sarray> t; // страницы it+sp*N_TIME_LIST, каналы подряд по N_TIME_SIZE точек
+    std::vector <sarray> U;
+
+    ShotSnapshot() : shot(0), N_TIME_LIST(0), N_SPECTROMETERS(0), N_CHANNELS(0), N_TIME_SIZE(0) {}
+};
+
+// каждый канал страницы записывается без потерь самым коротким из способов:
+// линейная сетка, разности int16 с шагом квантования, float32 или double
+bool writeShotSnapshot(const std::string &file_name, const ShotSnapshot &snapshot);
+// файл отображается в память через mmap; снимок другого архива или с другими размерами страниц не читается,
+// размеры заголовка проверяются до выделения памяти
+bool readShotSnapshot(const std::string &file_name, ShotSnapshot &snapshot, const std::string &archive_name,
+                      uint N_TIME_LIST, uint N_SPECTROMETERS, uint N_CHANNELS, uint N_TIME_SIZE);
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef __SHOT_STATISTICS_H__
+#define __SHOT_STATISTICS_H__
+
+#include <vector>
+#include <cmath>
+#include "SignalProcessing.h"
+#include "ThomsonCounter.h"
+
+// среднее, обновляется по одному значению
+struct RunningMean
+{
+    uint n;
+    double mean;
+
+    RunningMean() : n(0), mean(0.) {}
+    void add(double value) { n++; mean += (value-mean)/n; }
+};
+
+// среднее с весом 1/sigma^2, обновляется по одному значению
+struct WeightedMean
+{
+    double sum_w;
+    double mean;
+    bool valid; // false - был вес inf или nan, при прямом суммировании среднее было бы nan
+
+    WeightedMean() : sum_w(0.), mean(0.), valid(true) {}
+    void add(double value, double sigma);
+
+    bool isValid() const { return valid && sum_w > 0. && !std::isnan(mean); }
+    double getMean() const { return isValid() ? mean : 0.; }
+    double getError() const { return isValid() ? 1./sqrt(sum_w) : 0.; }
+};
+
+// статистика набора выстрелов, накапливается по мере обработки,
+// после addShot объекты выстрела можно удалить
+class ShotStatistics
+{
+private:
+    uint N_TIME_LIST;
+    uint N_SPECTROMETERS;
+    uint N_CHANNELS;
+    uint NUMBER_ENERGY_SPECTROMETER;
+    uint NUMBER_ENERGY_CHANNEL;
+
+    uint N_SHOTS;
+
+    std::vector <RunningMean> xPosition;
+    std::vector <RunningMean> timePoints;
+    std::vector <WeightedMean> Te; // sp+it*N_SPECTROMETERS
+    std::vector <WeightedMean> ne;
+
+    darray signals; // ch+N_CHANNELS*(sp+N_SPECTROMETERS*(it+N_TIME_LIST*nShot)), 8 байт на канал вместо объектов
+
+public:
+    ShotStatistics(uint N_TIME_LIST, uint N_SPECTROMETERS, uint N_CHANNELS, uint NUMBER_ENERGY_SPECTROMETER, uint NUMBER_ENERGY_CHANNEL);
+
+    void clear();
+    void reserve(uint N_SHOTS);
+
+    // страницы it+sp*N_TIME_LIST, как в ShotItem
+    void addShot(const std::vector <SignalProcessing*> &spArray, const std::vector <ThomsonCounter*> &counterArray);
+
+    uint getNShots() const { return N_SHOTS; }
+    double getSignal(uint it, uint sp, uint ch, uint nShot) const { return signals[ch+N_CHANNELS*(sp+N_SPECTROMETERS*(it+N_TIME_LIST*nShot))]; }
+    double getEnergy(uint it, uint nShot) const { return getSignal(it, NUMBER_ENERGY_SPECTROMETER, NUMBER_ENERGY_CHANNEL, nShot); }
+
+    void meanThomsonData(darray &Te, darray &TeError, darray &ne, darray &neError, darray &xPosition, darray &time_points) const;
+
+    // сигналы отмеченных страниц с энергией в [Emin, Emax] (Emax <= Emin - без ограничения), toEnergy - деленные на энергию
+    darray signalSample(uint sp, uint ch, const barray &time_mask, double Emin, double Emax, bool toEnergy) const;
+    darray energySample(const barray &time_mask) const;
+};
+
+#endif
@@ -2,6 +2,9 @@
 #define __SIGNAL_PROCESSING_H__
 
 #include <vector>
+#include <memory>
+#include "TimeAxis.h"
+#include "PulseDetector.h"
 
 typedef unsigned uint;
 typedef std::vector<double> darray;
@@ -25,6 +28,10 @@ struct SignalProcessingParameters
 
     double klim; // предельный наклон линии интеграла сигнала
 
+    int detector; // DetectorType
+    double snr_min; // порог отношения сигнал/шум для DETECTOR_MATCHED
+    std::shared_ptr <const PulseTemplate> pulse; // шаблон импульса для DETECTOR_MATCHED, общий для страниц
+
     SignalProcessingParameters(
                                 uint start_point_from_start_zero_line = 0, uint start_point_from_end_zero_line = 0,
                                 uint step_from_start_zero_line=0, uint step_from_end_zero_line=0, 
@@ -37,7 +44,8 @@ struct SignalProcessingParameters
                                 step_from_start_zero_line(step_from_start_zero_line), step_from_end_zero_line(step_from_end_zero_line),
                                 signal_point_start(signal_point_start), signal_point_step(signal_point_step),
                                 point_integrate_start(point_integrate_start),
-                                threshold(threshold), increase_point(increase_point), decrease_point(decrease_point), klim(klim)
+                                threshold(threshold), increase_point(increase_point), decrease_point(decrease_point), klim(klim),
+                                detector(DETECTOR_THRESHOLD), snr_min(0.)
     {}
 
 };
@@ -55,41 +63,49 @@ private:
     barray work_signal; // true - канал с импульсом, false - канал без импульса
 
     darray shifts; // массив значений нулевой линии сигнала от времени
-    darray UTintegrate_full; // массив проинтегрированных значений сигнала
-    darray t; // временные точки
-    darray UShift; // значение сигналов смещенных на shift
+    sarray UTintegrate_full; // массив проинтегрированных значений сигнала
+    TimeAxis timeAxis; // временные точки
+    sarray UShift; // значение сигналов смещенных на shift
 
     uint tSize; // число точек одного сигнала по времени
 
     darray signal_box;
     parray parametersArray;
+    std::vector <PulseMatch> pulses; // результат согласованного фильтра по каналам
+    darray detector_buffer;
 
     double coeff_to_energy;
 
 
-    bool checkSignal(const darray &t, const darray &U, const darray &UTintegral, uint channel, double signal, double sigma, double threshold=0., int increase_point=0, int decrease_point=0, double klim=-1., uint signal_points_start=1); // проверить был ли импульс в канале
-    void integrateSignal(const darray &t, const darray &U, uint channel, double UZero, uint point_integrate_start);    
-    void shiftSignal(const darray &U, uint channel, double UZero);
-    double countChannelSignal(const darray &UTintegrate, uint channel, uint signal_point_start, uint signal_point_step) const;
+    bool checkSignal(const sarray &U, const sarray &UTintegral, uint channel, double signal, double sigma, double threshold=0., int increase_point=0, int decrease_point=0, double klim=-1., uint signal_points_start=1); // проверить был ли импульс в канале
+    bool checkPulse(const sarray &U, uint channel, double signal, const SignalProcessingParameters &parameters); // согласованный фильтр вместо checkSignal
+    void integrateSignal(const sarray &U, uint channel, double UZero, uint point_integrate_start);    
+    void shiftSignal(const sarray &U, uint channel, double UZero);
+    double countChannelSignal(const sarray &UTintegrate, uint channel, uint signal_point_start, uint signal_point_step) const;
     double countChannelSignalSigma(double signal, const std::vector <std::pair<double, double>> &sigmaCoeff, uint channel) const;
-    double findZeroLine(const darray &t, const darray &U, uint channel, uint step_from_start_zero_line, uint step_from_end_zero_line, uint start_point_from_start_zero_line, uint start_point_from_end_zero_line) const;
+    double findZeroLine(const sarray &U, uint channel, uint step_from_start_zero_line, uint step_from_end_zero_line, uint start_point_from_start_zero_line, uint start_point_from_end_zero_line) const;
 
 
-    SignalProcessingParameters parametersAdaptive(const SignalProcessingParameters &par, const darray &t, const darray &U, uint channel);
+    SignalProcessingParameters parametersAdaptive(const SignalProcessingParameters &par, const sarray &U, uint channel);
     
 public:
     
-    SignalProcessing(const darray &t_full, const darray &U_full, uint N_CHANNELS, const parray &parametersArray, const std::vector<std::pair<double, double>> &sigmaCoeff, const barray &work_mask={}, double coeff_to_energy=1.);
+    SignalProcessing(const sarray &t_full, const sarray &U_full, uint N_CHANNELS, const parray &parametersArray, const std::vector<std::pair<double, double>> &sigmaCoeff, const barray &work_mask={}, double coeff_to_energy=1.);
     SignalProcessing(const darray &signals, const darray &signals_sigma, const barray &work_signal={}, double coeff_to_energy=1.);
 
+    // повторная инициализация объекта, выделенная под массивы память не освобождается (ShotArena)
+    void assign(const sarray &t_full, const sarray &U_full, uint N_CHANNELS, const parray &parametersArray, const std::vector<std::pair<double, double>> &sigmaCoeff, const barray &work_mask={}, double coeff_to_energy=1.);
+    void assign(const darray &signals, const darray &signals_sigma, const barray &work_signal={}, double coeff_to_energy=1.);
+
     const darray &getSignals() const { return signals; }
     const darray &getSignalsSigma() const { return signals_sigma; }
     const barray &getWorkSignals() const { return work_signal; }
     const darray &getShifts() const { return shifts; }
-    const darray &getUShift() const { return UShift; }
-    const darray &getT() const { return t; }
-    const darray &getUTintegrateSignal() const { return UTintegrate_full; }
+    const sarray &getUShift() const { return UShift; }
+    const TimeAxis &getTimeAxis() const { return timeAxis; }
+    const sarray &getUTintegrateSignal() const { return UTintegrate_full; }
     const darray &getSignalBox() const { return signal_box; }
+    const std::vector <PulseMatch> &getPulses() const { return pulses; }
     const parray &getParameters() const { return parametersArray; }
     uint getNChannels() const { return N_CHANNELS; }
     uint getTSize() const { return tSize; }
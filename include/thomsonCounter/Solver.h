@@ -3,25 +3,24 @@
 
 #include "NonLinearOptimize.h"
 #include "Spectrum.h"
+#include "SRF.h"
 
 class SolveEquation : public optimize::NonLinearOptimize 
 {
 private:
-    double dl;
-    double lMin, lMax;
-    const double * const SRF_1;
-    const double * const SRF_2;
+    const SparseSRF &srf;
+    uint ch1, ch2;
+    SRFBand band; // спектр только в полосах двух каналов
     double theta;
     double lambda_reference;
-    uint N_LAMBDA;
 
     double f(double x, const darray &params) const override;
 
 public:
 
-    SolveEquation(double value, const double * const SRF_1, const double * const &SRF_2, double lMin, double lMax, double theta, double lambda_reference, uint N_LAMBDA, unsigned iteration_limit=100000) :
-                    NonLinearOptimize({1}, {value}, iteration_limit), dl((lMax-lMin)/(N_LAMBDA-1.)), lMin(lMin), lMax(lMax),
-                     SRF_1(SRF_1), SRF_2(SRF_2), theta(theta), lambda_reference(lambda_reference), N_LAMBDA(N_LAMBDA)
+    SolveEquation(double value, const SparseSRF &srf, uint ch1, uint ch2, double theta, double lambda_reference, unsigned iteration_limit=100000) :
+                    NonLinearOptimize({1}, {value}, iteration_limit), srf(srf), ch1(ch1), ch2(ch2), band(srf.getUnion(ch1, ch2)),
+                    theta(theta), lambda_reference(lambda_reference)
     {
     }
 
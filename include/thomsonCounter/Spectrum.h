@@ -13,6 +13,9 @@ double SNorma(double li, double theta);
 double convolution(const double *const SRF, const darray &S, double lMin, double lMax);
 double countA(double Te);
 double countT(double a);
+// exp в SRelative, SClassic, countSArray и fillSArray по уровню getExpTier() (FastMath.h)
 darray countSArray(uint N_LAMBDA ,double lMin, double dl, double a, double Aampl, double theta, double lambda_reference);
+// countSArray в готовый массив S, без выделения памяти
+void fillSArray(double *S, uint N_LAMBDA, double lMin, double dl, double a, double Aampl, double theta, double lambda_reference);
 
 #endif
\ No newline at end of file
@@ -2,9 +2,15 @@
 #define __THOMSON_COUNTER_H__
 
 #include <vector>
+#include <array>
 #include <string>
+#include <memory>
 #include "Spectrum.h"
+#include "SRF.h"
 #include "SignalProcessing.h"
+#include "ChannelPairs.h"
+#include "ResponseTable.h"
+#include "ConvolutionTable.h"
 
 typedef std::vector<double> darray;
 typedef std::vector<uint> uiarray;
@@ -26,6 +32,10 @@ private:
     uint N_CHANNELS_WORK;
     darray SCount;
     darray SRF;
+    SparseSRF srf_bands; // SRF в полосах пропускания каналов, для сверток
+    std::string srf_file_name; // из каких файлов прочитаны SRF и SCount
+    std::string convolution_file_name;
+    std::shared_ptr <const ConvolutionTable> convolution_table; // SCount построен по SRF, nullptr - из файла
 
     uint N_LAMBDA;
     double lMin;
@@ -42,19 +52,23 @@ private:
     barray channel_work;
     double theta;
     double lambda_reference;
+    std::shared_ptr <const ResponseTable> response; // nullptr - спектры считаются при каждом вызове
 
     double alpha;
     double epsilon;
     uint iter_limit;
 
     uint N_RATIO;
-    std::vector<std::pair<uint, uint>> channels_number;
+    const ChannelPairs *channel_pairs; // общий для счетчиков с тем же N_CHANNELS
+    std::vector <int> ratio_index; // номер пары -> индекс в TijArray, -1 - пара не использована
 
     darray TijArray;
     darray sigmaTijArray;
     darray devTijArray;
     uiarray number_ratio;
     darray weight;
+    darray gradient; // [2*k] dTk/da_ch1, [2*k+1] dTk/da_ch2 для использованных пар
+    darray covariance; // [j+k*size] при j < k, ковариации использованных пар
     darray Ki;
     darray sigmaKi;
 
@@ -89,29 +103,32 @@ private:
 
     void createChannelsNumberArray();
 
-    int delta(uint i, uint j) const {
-        return i == j;
-    }
     double findTZeroApproximation() const;
+    double findTZeroApproximation(const darray &S, uint N_T, double T0, double dT) const; // S[it+ch*N_T]
+    bool isResponse(double Te) const { return response && response->contains(Te, theta); }
 
 
     double devFij(uint ch1, uint ch2, double Tij) const;
+    template <uint N>
+    void devFPairs(double Tij, std::array<double, N*(N-1)/2> &dev) const; // devFij всех пар, свертки по одной на канал
     //double devFij_zero(uint ch1, uint ch2, double T) const;
 
     double countTij(uint ch1, uint ch2);
     double countSigmaRij(uint ch1, uint ch2) const;
     double countSigmaTij(uint ch1, uint ch2, double devTij) const;
     double cov(uint k, uint ks) const;
+    void createCovariance();
 
     void createWeight();
 
     double countWeightT() const;
     double countWeightErrorT() const;
 
-    int findRatioNumber(uint ch1, uint ch2) const;
+    int findRatioNumber(uint ch1, uint ch2) const; // индекс в TijArray, -1 - пара не использована
 
     const double * const getSRFch(uint ch) const { return SRF.data()+ch*N_LAMBDA; }
-    inline double getSCount(uint it, uint ch) const { return SCount[it+ch*N_TEMPERATURE]; }
+    // спектр при Te только в точках полосы band, для srf_bands.convolution
+    darray countSBand(const SRFBand &band, double Te, double Aampl) const;
 
 
     bool isChannelUseToCount(uint ch1, uint ch2, const barray &is_channel_use) const;
@@ -129,12 +146,32 @@ private:
                     const std::string &srf_file_name, const std::string &convolution_file_name, const SignalProcessing &sp, double theta, const darray &Ki, const darray &sigmaKi,
                     double energy, double sigmaEnergy, double time_points, double x_position,
                     double lambda_reference, int selectionMethod=0);
+
+    // повторная инициализация объекта с сохранением памяти (ShotArena), SRF и свертки читаются только при смене файла
+    void assign(uint N_CHANNELS,
+                const std::string &srf_file_name, const std::string &convolution_file_name, const darray &signal,
+                const darray & signal_error, double theta, const darray &Ki, const darray &sigmaKi,
+                double energy, double sigmaEnergy, double time_point, double x_position,
+                const barray &channel_work,
+                double lambda_reference, int selectionMethod=0);
+    void assign(uint N_CHANNELS,
+                const std::string &srf_file_name, const std::string &convolution_file_name, const SignalProcessing &sp, double theta, const darray &Ki, const darray &sigmaKi,
+                double energy, double sigmaEnergy, double time_point, double x_position,
+                double lambda_reference, int selectionMethod=0);
                      
+    // таблица отклика для theta счетчика, сбрасывается в assign, Te0 пересчитывается по таблице
+    void setResponseTable(const std::shared_ptr<const ResponseTable> &response);
+    const std::shared_ptr<const ResponseTable> &getResponseTable() const { return response; }
+    // SCount из таблицы вместо файла свертки, до следующего чтения файла в assign
+    void setConvolution(const std::shared_ptr<const ConvolutionTable> &table);
+
     bool count(const double alpha=0.001, const uint iter_limit=10000, const double epsilon=1e-12);
     bool countConcentration(double Te=-1.);
     //bool countConcentration();
     
     bool countSignalResult();
+    void setResult(double Te, double TeError, double ne, double neError, double rmse, double rmsePlus, double rmseMinus,
+                   const darray &signalResult, const darray &signalResultPlus, const darray &signalResultMinus); // восстановить посчитанный результат (из кэша)
     
     darray countSyntheticSignal(double Te, double ne, bool all=false) const; // считаем синтетический сигнал Te эВ ne 10^13 см^-3
     double countRMSE(const darray &signal_result, const darray &singnal, const darray &signal_error, bool all=false) const;
@@ -152,8 +189,8 @@ private:
     const darray &getSignalResultPlus() const { return signalResultPlus; }
     const darray &getSignalResultMinus() const { return signalResultMinus; }
 
-    double getTij (uint ch1, uint ch2) const { return TijArray[findRatioNumber(ch1, ch2)]; }
-    double getSigmaTij (uint ch1, uint ch2) const { return sigmaTijArray[findRatioNumber(ch1, ch2)]; }
+    double getTij (uint ch1, uint ch2) const { int k = findRatioNumber(ch1, ch2); return k < 0 ? 0. : TijArray[k]; }
+    double getSigmaTij (uint ch1, uint ch2) const { int k = findRatioNumber(ch1, ch2); return k < 0 ? 0. : sigmaTijArray[k]; }
     double getTij (uint k) const { return TijArray[k]; }
     uint getNumberRatio_ij(uint k) const { return number_ratio[k]; }
     double getSigmaTij (uint k) const { return sigmaTijArray[k]; }
@@ -164,8 +201,8 @@ private:
     const darray &getSignalError() const { return signal_error; }
     const barray &getWorkSignal() const { return channel_work; }
 
-    uint getCh1(uint k) const { return channels_number[k].first; }
-    uint getCh2(uint k) const { return channels_number[k].second; }
+    uint getCh1(uint k) const { return channel_pairs->getPair(k).first; }
+    uint getCh2(uint k) const { return channel_pairs->getPair(k).second; }
     uint getNRatio() const { return N_RATIO; }
     uint getNRatioUse() const { return TijArray.size(); } 
     //uint getChannelNeCount() const { return chToNeCount; }
@@ -184,6 +221,7 @@ private:
     double getEnergy() const { return energy; }
     double getSigmaEnergy() const { return sigmaEnergy; }
     double getTimePoint() const { return time_point; }
+    const darray &getKi() const { return Ki; }
     double getXPositon() const { return x_positon; }
 
 
@@ -0,0 +1,50 @@
+#ifndef __TIME_AXIS_H__
+#define __TIME_AXIS_H__
+
+#include <vector>
+
+typedef unsigned uint;
+typedef std::vector<double> darray;
+
+// отсчеты осциллограмм, с THOMSON_FLOAT_SAMPLES хранятся в float, суммы и интегралы считаются в double
+#ifdef THOMSON_FLOAT_SAMPLES
+typedef float sample_t;
+#else
+typedef double sample_t;
+#endif
+typedef std::vector<sample_t> sarray;
+
+// временная ось страницы: для каждого канала t0 + i*dt,
+// явные отсчеты хранятся только если сетка хотя бы одного канала неравномерная
+class TimeAxis
+{
+private:
+    uint N_CHANNELS;
+    uint tSize;
+    bool uniform;
+    darray t0; // по каналам
+    darray dt;
+    sarray t; // каналы подряд по tSize точек, пустой при равномерной сетке
+
+    bool findUniform(const sarray &t_full, uint channel, double &t0, double &dt) const;
+
+public:
+    TimeAxis() : N_CHANNELS(0), tSize(0), uniform(true) {}
+
+    // память массивов остается от прошлого выстрела (ShotArena)
+    void assign(const sarray &t_full, uint N_CHANNELS);
+    void clear();
+
+    bool isUniform() const { return uniform; }
+    uint size() const { return tSize; }
+    uint getNChannels() const { return N_CHANNELS; }
+
+    double at(uint channel, uint i) const { return uniform ? t0[channel] + i*dt[channel] : (double) t[channel*tSize+i]; }
+    double step(uint channel, uint i) const { return uniform ? dt[channel] : (double) t[channel*tSize+i] - t[channel*tSize+i-1]; } // t[i]-t[i-1]
+    double getStep(uint channel) const { return dt[channel]; } // только при равномерной сетке
+
+    uint lowerBound(uint channel, double time) const; // первая точка с t >= time, size() если такой нет
+    sarray toArray() const; // явные отсчеты всех каналов, для отрисовки
+};
+
+#endif
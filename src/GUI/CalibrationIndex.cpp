@@ -0,0 +1,176 @@
+#include "CalibrationIndex.h"
+#include <iostream>
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cmath>
+
+#include <sys/stat.h>
+
+#include <dasarchive/service.h>
+#include <dasarchive/TSignal.h>
+#include <dasarchive/TSignalC.h>
+#include <TFile.h>
+
+#define LAST_OLD_FORMAT_SHOT 57844
+#define LAST_OLD_CALIBRATION_SHOT 57986
+
+namespace {
+
+// время изменения в нс и размер файла, -1 если файла нет
+std::pair<long long, long long> fileStamp(const std::string &file_name)
+{
+    struct stat st;
+    if (stat(file_name.c_str(), &st) != 0)
+        return {-1, -1};
+    return {st.st_mtim.tv_sec*1000000000LL + st.st_mtim.tv_nsec, (long long) st.st_size};
+}
+
+}
+
+bool CalibrationIndex::isArchiveChanged() const
+{
+    std::pair<long long, long long> stamp = fileStamp(archive_name);
+    return stamp.first != archive_mtime || stamp.second != archive_size;
+}
+
+void CalibrationIndex::load(const std::string &archive_name)
+{
+    this->archive_name = archive_name;
+    loaded = true;
+    ranges.clear();
+
+    // метка до чтения: запись во время построения индекса заметит следующий поиск
+    std::pair<long long, long long> stamp = fileStamp(archive_name);
+    archive_mtime = stamp.first;
+    archive_size = stamp.second;
+
+    // старые калибровки не записаны в архив
+    ranges.push_back({INT_MIN, LAST_OLD_FORMAT_SHOT, "", {
+            0., 96.704*M_PI/180., 0.0813323, 0.0813323,
+            -32., 99.474*M_PI/180., 0.0742564, 0.0742564,
+            -63.5, 102.158*M_PI/180., 0.0688669, 0.0688669,
+            -95.5, 104.831*M_PI/180., 0.0652062, 0.0652062,
+            -127.5, 107.439*M_PI/180., 0.0577925, 0.0577925,
+            -156, 109.687*M_PI/180., 0.0681893, 0.0681893,
+            0.287
+        }, true});
+    ranges.push_back({LAST_OLD_FORMAT_SHOT+1, LAST_OLD_CALIBRATION_SHOT, "", {
+            0., 96.704*M_PI/180., 0.065474, 0.065474,
+            -32., 99.474*M_PI/180., 0.0664481, 0.0664481,
+            -63.5, 102.158*M_PI/180., 0.062434, 0.062434,
+            -95.5, 104.831*M_PI/180., 0.0649258, 0.0649258,
+            -127.5, 107.439*M_PI/180., 0.0637577, 0.0637577,
+            -156, 109.687*M_PI/180., 0.0753984, 0.0753984,
+            0.287
+        }, true});
+
+    TFile *file = OpenArchive(archive_name.c_str());
+    TDirectory *dir = file != nullptr ? file->GetDirectory("Calibration") : nullptr;
+    if (dir == nullptr)
+    {
+        CloseArchive();
+        return;
+    }
+
+    std::vector <int> sets;
+    TIter next(dir->GetListOfKeys());
+    while (TObject *key = next())
+    {
+        char *end = nullptr;
+        long set = strtol(key->GetName(), &end, 10);
+        if (end != key->GetName() && *end == '\0' && set > LAST_OLD_CALIBRATION_SHOT && set < INT_MAX)
+            sets.push_back(set);
+    }
+    std::sort(sets.begin(), sets.end());
+    sets.erase(std::unique(sets.begin(), sets.end()), sets.end());
+
+    // проверка, что архив относит первый выстрел набора к этому набору, иначе индекс не используется
+    bool valid = true;
+    for (int set : sets)
+    {
+        TString set_name = TString::Format("%d", set);
+        if (file->GetDirectory(set_name) != nullptr && GetShotCalibration(set) != set_name)
+        {
+            std::cerr << "набор калибровок " << set << " не совпадает с GetShotCalibration, калибровки читаются по выстрелу\n";
+            valid = false;
+            break;
+        }
+    }
+    CloseArchive();
+
+    if (!valid)
+        return;
+
+    for (uint i = 0; i < sets.size(); i++)
+        ranges.push_back({sets[i], i+1 < sets.size() ? sets[i+1]-1 : INT_MAX, std::to_string(sets[i]), darray(), false});
+}
+
+const darray &CalibrationIndex::rangeCalibration(Range &range)
+{
+    if (range.loaded)
+        return range.calibration;
+
+    range.loaded = true;
+    if (OpenArchive(archive_name.c_str()) != nullptr)
+    {
+        TSignalC *calibration_signal = (TSignalC*) GetCalibration(calibration_name.c_str(), range.set_name.c_str());
+        if (calibration_signal != nullptr)
+        {
+            uint size = calibration_signal->GetSize()/sizeof(double);
+            double *cal = reinterpret_cast<double*> (calibration_signal->GetArray());
+            range.calibration.assign(cal, cal+size);
+        }
+        delete calibration_signal;
+    }
+    CloseArchive();
+
+    return range.calibration;
+}
+
+CalibrationIndex::Range *CalibrationIndex::findRange(int shot)
+{
+    auto it = std::upper_bound(ranges.begin(), ranges.end(), shot, [](int shot, const Range &range) { return shot < range.first; });
+    if (it == ranges.begin())
+        return nullptr;
+    --it;
+    return shot <= it->last ? &*it : nullptr;
+}
+
+bool CalibrationIndex::find(const std::string &archive_name, int shot, darray &calibration)
+{
+    std::lock_guard <std::mutex> lock(mutex);
+    if (!loaded || archive_name != this->archive_name || isArchiveChanged()) // stat без открытия архива
+        load(archive_name);
+
+    Range *range = findRange(shot);
+    if (range == nullptr)
+        return false;
+
+    calibration = rangeCalibration(*range);
+    return true;
+}
+
+bool CalibrationIndex::findLast(const std::string &archive_name, darray &calibration)
+{
+    std::lock_guard <std::mutex> lock(mutex);
+    if (!loaded || archive_name != this->archive_name || isArchiveChanged()) // stat без открытия архива
+        load(archive_name);
+
+    for (auto it = ranges.rbegin(); it != ranges.rend() && !it->set_name.empty(); ++it)
+    {
+        if (!rangeCalibration(*it).empty())
+        {
+            calibration = it->calibration;
+            return true;
+        }
+    }
+    return false;
+}
+
+void CalibrationIndex::invalidate()
+{
+    std::lock_guard <std::mutex> lock(mutex);
+    loaded = false;
+    ranges.clear();
+}
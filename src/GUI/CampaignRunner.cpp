@@ -0,0 +1,239 @@
+#include "CampaignRunner.h"
+#include <iostream>
+#include <deque>
+#include <map>
+#include <thread>
+#include <algorithm>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <dasarchive/service.h>
+#include <TSystem.h>
+
+#include "thomsonCounter/ResultSet.h"
+#include "ResultTree.h"
+
+bool CampaignRunner::createShotList(const ShotSettings &settings, uint first, uint last, uiarray &shots) const
+{
+    int lastShot = 0;
+    OpenArchive(settings.archive_name.c_str());
+    pipeline.getShot(lastShot);
+    CloseArchive();
+
+    if (lastShot <= 0)
+    {
+        std::cerr << "не удалось получить номер последнего выстрела в архиве " << settings.archive_name << "!\n";
+        return false;
+    }
+
+    shots.clear();
+    for (uint shot = first; shot <= std::min(last, (uint) lastShot); shot++)
+        shots.push_back(shot);
+    return true;
+}
+
+int CampaignRunner::runWorker(const std::string &input_file_name, uint first, uint last, const std::string &out_file_name,
+                              const std::string &snapshot_folder, bool useCache) const
+{
+    ShotSettings settings;
+    if (!pipeline.createSettings(input_file_name, settings, useCache))
+        return 1;
+    settings.snapshot_folder = snapshot_folder;
+
+    uiarray shots;
+    if (!createShotList(settings, first, last, shots))
+        return 1;
+
+    ResultSetWriter writer;
+    if (!writer.open(out_file_name))
+        return 1;
+
+    bool complete = pipeline.run(settings, shots, 2, [&](ShotItem &item) {
+        return writer.add(item.shot, pipeline.createPages(item));
+    });
+
+    if (!complete || !writer.close())
+        return 1;
+
+    std::cout << "обработано выстрелов: " << shots.size() << "\n";
+    return 0;
+}
+
+int CampaignRunner::runSnapshots(const std::string &input_file_name, uint first, uint last, const std::string &snapshot_folder) const
+{
+    ShotSettings settings;
+    if (!pipeline.createSettings(input_file_name, settings))
+        return 1;
+
+    uiarray shots;
+    if (!createShotList(settings, first, last, shots))
+        return 1;
+
+    return pipeline.exportSnapshots(settings, shots, snapshot_folder) ? 0 : 1;
+}
+
+int CampaignRunner::runTuning(const std::string &input_file_name, uint first, uint last, const std::string &out_file_name) const
+{
+    ShotSettings settings;
+    if (!pipeline.createSettings(input_file_name, settings))
+        return 1;
+
+    uiarray shots;
+    if (!createShotList(settings, first, last, shots))
+        return 1;
+
+    std::vector <parray> parametersArray;
+    if (!pipeline.tuneParameters(settings, shots, TuneGrid(), parametersArray) ||
+        !pipeline.writeParametersToSignalProcessing(out_file_name, parametersArray))
+        return 1;
+
+    std::cout << "параметры записаны в " << out_file_name << "\n";
+    return 0;
+}
+
+pid_t CampaignRunner::startWorker(const std::string &executable, const std::string &input_file_name, const Shard &shard) const
+{
+    std::string first = std::to_string(shard.first);
+    std::string last = std::to_string(shard.last);
+    std::string log_file_name = shard.file_name + ".log";
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        int log = open(log_file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (log >= 0)
+        {
+            dup2(log, STDOUT_FILENO);
+            dup2(log, STDERR_FILENO);
+            close(log);
+        }
+        execl(executable.c_str(), executable.c_str(), "--worker", input_file_name.c_str(), first.c_str(), last.c_str(), shard.file_name.c_str(), (char*) nullptr);
+        _exit(127);
+    }
+
+    return pid;
+}
+
+int CampaignRunner::runCampaign(const std::string &executable, const std::string &input_file_name, uint first, uint last, uint n_proc,
+                                const std::string &out_file_name, uint shard_size, uint max_attempts) const
+{
+    if (first > last)
+        std::swap(first, last);
+    if (n_proc == 0)
+        n_proc = std::max(1u, std::thread::hardware_concurrency());
+    if (shard_size == 0)
+        shard_size = 1;
+
+    std::string shard_folder = out_file_name + ".shards/";
+    gSystem->mkdir(shard_folder.c_str(), kTRUE);
+
+    std::vector <Shard> shards;
+    for (uint shot = first; shot <= last; shot += shard_size)
+    {
+        uint shard_last = std::min(last, shot+shard_size-1);
+        shards.push_back({shot, shard_last, shard_folder + "shard_" + std::to_string(shot) + "_" + std::to_string(shard_last) + ".dat", 0});
+        if (shard_last == last)
+            break;
+    }
+
+    std::deque <uint> pending;
+    std::vector <std::pair<int32_t, uint64_t>> index;
+    for (uint i = 0; i < shards.size(); i++)
+    {
+        if (readResultSetIndex(shards[i].file_name, index))
+            std::cout << "shard " << shards[i].first << "-" << shards[i].last << " уже посчитан\n";
+        else
+            pending.push_back(i);
+    }
+
+    std::map <pid_t, uint> running;
+    std::vector <uint> failed;
+
+    while (!pending.empty() || !running.empty())
+    {
+        while (running.size() < n_proc && !pending.empty())
+        {
+            uint i = pending.front();
+            pending.pop_front();
+            shards[i].attempts++;
+
+            pid_t pid = startWorker(executable, input_file_name, shards[i]);
+            if (pid < 0)
+            {
+                std::cerr << "не удалось запустить процесс для shard " << shards[i].first << "-" << shards[i].last << "!\n";
+                failed.push_back(i);
+                continue;
+            }
+            running[pid] = i;
+        }
+
+        if (running.empty())
+            break;
+
+        int status = 0;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0)
+            break;
+
+        auto it = running.find(pid);
+        if (it == running.end())
+            continue;
+
+        uint i = it->second;
+        running.erase(it);
+
+        bool success = WIFEXITED(status) && WEXITSTATUS(status) == 0 && readResultSetIndex(shards[i].file_name, index);
+        if (success)
+        {
+            std::cout << "shard " << shards[i].first << "-" << shards[i].last << " готов\n";
+        }
+        else if (shards[i].attempts < max_attempts)
+        {
+            std::cerr << "shard " << shards[i].first << "-" << shards[i].last << " завершился с ошибкой, перезапуск\n";
+            pending.push_back(i);
+        }
+        else
+        {
+            std::cerr << "shard " << shards[i].first << "-" << shards[i].last << " не посчитан, см. " << shards[i].file_name << ".log\n";
+            failed.push_back(i);
+        }
+    }
+
+    std::vector <std::string> file_names;
+    for (uint i = 0; i < shards.size(); i++)
+        if (std::find(failed.begin(), failed.end(), i) == failed.end())
+            file_names.push_back(shards[i].file_name);
+
+    if (!mergeResultSets(file_names, out_file_name))
+        return 1;
+
+    // таблица для анализа кампании, пересоздается вместе с набором результатов
+    ResultTree tree(pipeline.getNTimeList());
+    std::string tree_file_name = out_file_name + ".root";
+    if (!tree.open(tree_file_name, false) ||
+        !readResultSet(out_file_name, [&tree](int shot, const rarray &pages) { return tree.add(shot, pages); }) ||
+        !tree.close())
+    {
+        std::cerr << "не удалось записать " << tree_file_name << "!\n";
+        return 1;
+    }
+
+    if (!failed.empty())
+    {
+        std::cerr << "не посчитано частей: " << failed.size() << ", повторный запуск пересчитает только их\n";
+        return 1;
+    }
+
+    for (const Shard &shard : shards)
+    {
+        std::remove(shard.file_name.c_str());
+        std::remove((shard.file_name + ".log").c_str());
+    }
+    gSystem->Unlink(shard_folder.c_str());
+
+    std::cout << "результат записан в " << out_file_name << " и " << tree_file_name << "\n";
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include "DecimatedGraph.h"
+#include <TPad.h>
+#include <algorithm>
+#include <cstdlib>
+
+void DecimatedGraph::addPoint(int i)
+{
+    dx.push_back(fX[i]);
+    dy.push_back(fY[i]);
+    dex.push_back(fEX != nullptr ? fEX[i] : 0.);
+    dey.push_back(fEY != nullptr ? fEY[i] : 0.);
+}
+
+bool DecimatedGraph::decimate(double xmin, double xmax, int buckets)
+{
+    if (fNpoints < 2 || buckets <= 0 || !std::is_sorted(fX, fX+fNpoints))
+        return false;
+
+    // видимые точки и по одной соседней с каждой стороны, чтобы линия доходила до края pad
+    int i0 = std::lower_bound(fX, fX+fNpoints, xmin) - fX;
+    int i1 = std::upper_bound(fX, fX+fNpoints, xmax) - fX;
+    if (i0 > 0)
+        i0--;
+    if (i1 < fNpoints)
+        i1++;
+
+    if (i1 - i0 <= 2*buckets)
+        return false;
+
+    dx.clear();
+    dy.clear();
+    dex.clear();
+    dey.clear();
+
+    addPoint(i0);
+
+    double width = (fX[i1-1] - fX[i0]) / buckets;
+    int i = i0+1;
+    for (int b = 1; b <= buckets && i < i1-1; b++)
+    {
+        double end = b == buckets ? fX[i1-1] : fX[i0] + b*width;
+        int imin = -1;
+        int imax = -1;
+        for (; i < i1-1 && fX[i] <= end; i++)
+        {
+            if (imin < 0 || fY[i] < fY[imin])
+                imin = i;
+            if (imax < 0 || fY[i] > fY[imax])
+                imax = i;
+        }
+
+        if (imin < 0)
+            continue;
+
+        // порядок по времени, чтобы линия не возвращалась назад
+        addPoint(std::min(imin, imax));
+        if (imin != imax)
+            addPoint(std::max(imin, imax));
+    }
+
+    addPoint(i1-1);
+    return true;
+}
+
+void DecimatedGraph::Paint(Option_t *chopt)
+{
+    if (!decimation || gPad == nullptr)
+    {
+        TGraphErrors::Paint(chopt);
+        return;
+    }
+
+    int pixels = std::abs(gPad->UtoPixel(1.) - gPad->UtoPixel(0.));
+    if (!decimate(gPad->GetUxmin(), gPad->GetUxmax(), pixels))
+    {
+        TGraphErrors::Paint(chopt);
+        return;
+    }
+
+    // на время отрисовки график показывает прореженные массивы, полные данные не меняются
+    double *x = fX;
+    double *y = fY;
+    double *ex = fEX;
+    double *ey = fEY;
+    int n = fNpoints;
+
+    fX = dx.data();
+    fY = dy.data();
+    fEX = dex.data();
+    fEY = dey.data();
+    fNpoints = dx.size();
+
+    TGraphErrors::Paint(chopt);
+
+    fX = x;
+    fY = y;
+    fEX = ex;
+    fEY = ey;
+    fNpoints = n;
+}
@@ -0,0 +1,122 @@
+#include "GraphPool.h"
+
+std::map <uint, std::vector<DecimatedGraph*>> GraphPool::graphs;
+std::map <std::tuple<uint, double, double>, std::vector<TH1D*>> GraphPool::hists;
+uint GraphPool::nFree = 0;
+
+void GraphPool::put(DecimatedGraph *g)
+{
+    if (nFree >= MAX_FREE)
+    {
+        delete g;
+        return;
+    }
+    graphs[g->GetN()].push_back(g);
+    nFree++;
+}
+
+void GraphPool::put(TH1D *h)
+{
+    if (nFree >= MAX_FREE)
+    {
+        delete h;
+        return;
+    }
+    hists[std::make_tuple((uint) h->GetNbinsX(), h->GetXaxis()->GetXmin(), h->GetXaxis()->GetXmax())].push_back(h);
+    nFree++;
+}
+
+DecimatedGraph *GraphPool::getGraph(uint points)
+{
+    std::vector <DecimatedGraph*> &free = graphs[points];
+    if (free.empty())
+        return new DecimatedGraph(points);
+
+    DecimatedGraph *g = free.back();
+    free.pop_back();
+    nFree--;
+
+    g->setDecimation(false);
+    g->ResetAttLine();
+    g->ResetAttMarker();
+    g->ResetBit(kCannotPick);
+    return g;
+}
+
+TH1D *GraphPool::getHist(uint nbins, double xmin, double xmax)
+{
+    std::vector <TH1D*> &free = hists[std::make_tuple(nbins, xmin, xmax)];
+    if (free.empty())
+    {
+        TH1D *h = new TH1D("", "", nbins, xmin, xmax);
+        h->SetDirectory(nullptr);
+        return h;
+    }
+
+    TH1D *h = free.back();
+    free.pop_back();
+    nFree--;
+
+    h->Reset();
+    h->ResetAttLine();
+    return h;
+}
+
+void GraphPool::release(TMultiGraph *mg)
+{
+    TList *list = mg != nullptr ? mg->GetListOfGraphs() : nullptr;
+    if (list == nullptr)
+        return;
+
+    std::vector <DecimatedGraph*> free;
+    TIter next(list);
+    TObject *obj;
+    while ((obj = next()))
+        if (DecimatedGraph *g = dynamic_cast<DecimatedGraph*>(obj)) // созданные не через пул удалит mg
+            free.push_back(g);
+
+    for (DecimatedGraph *g : free)
+    {
+        list->Remove(g);
+        put(g);
+    }
+}
+
+void GraphPool::release(THStack *hs)
+{
+    TList *list = hs != nullptr ? hs->GetHists() : nullptr;
+    if (list == nullptr)
+        return;
+
+    std::vector <TH1D*> free;
+    TIter next(list);
+    TObject *obj;
+    while ((obj = next()))
+        if (obj->InheritsFrom(TH1D::Class()))
+            free.push_back((TH1D*) obj);
+
+    for (TH1D *h : free)
+    {
+        list->Remove(h);
+        put(h);
+    }
+}
+
+void GraphPool::release(TVirtualPad *pad)
+{
+    TList *list = pad != nullptr ? pad->GetListOfPrimitives() : nullptr;
+    if (list == nullptr)
+        return;
+
+    TIter next(list);
+    TObject *obj;
+    while ((obj = next()))
+    {
+        if (obj->InheritsFrom(TMultiGraph::Class()))
+            release((TMultiGraph*) obj);
+        else if (obj->InheritsFrom(THStack::Class()))
+            release((THStack*) obj);
+        else if (obj->InheritsFrom(TVirtualPad::Class()))
+            release((TVirtualPad*) obj);
+    }
+}
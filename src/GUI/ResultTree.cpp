@@ -0,0 +1,125 @@
+#include "ResultTree.h"
+#include <iostream>
+#include <Compression.h>
+
+ResultTree::ResultTree(uint N_TIME_LIST, uint autosave_shots) :
+    N_TIME_LIST(N_TIME_LIST), autosave_shots(autosave_shots), file(nullptr), tree(nullptr), nShots(0),
+    signals(new darray), signals_sigma(new darray), signalResult(new darray), work_signal(new barray)
+{
+}
+
+ResultTree::~ResultTree()
+{
+    close();
+    delete signals;
+    delete signals_sigma;
+    delete signalResult;
+    delete work_signal;
+}
+
+template <class T>
+void ResultTree::bind(const char *name, T *address, bool create)
+{
+    if (create)
+        tree->Branch(name, address);
+    else
+        tree->SetBranchAddress(name, address);
+}
+
+bool ResultTree::open(const std::string &file_name, bool append)
+{
+    close();
+
+    file = TFile::Open(file_name.c_str(), append ? "UPDATE" : "RECREATE");
+    if (file == nullptr || file->IsZombie())
+    {
+        std::cerr << "не удалось открыть файл: " << file_name << "!\n";
+        delete file;
+        file = nullptr;
+        return false;
+    }
+    file->SetCompressionSettings(ROOT::RCompressionSetting::EDefaults::kUseAnalysis); // LZ4, быстрое чтение
+
+    tree = file->Get<TTree>("thomson");
+    bool create = tree == nullptr;
+    if (create)
+        tree = new TTree("thomson", "Thomson results, entry (shot, sp, it)");
+
+    bind("shot", &shot, create);
+    bind("sp", &sp, create);
+    bind("it", &it, create);
+    bind("time", &time_point, create);
+    bind("x", &x_position, create);
+    bind("energy", &energy, create);
+    bind("theta", &theta, create);
+    bind("Te", &Te, create);
+    bind("TeError", &TeError, create);
+    bind("ne", &ne, create);
+    bind("neError", &neError, create);
+    bind("rmse", &rmse, create);
+    bind("rmsePlus", &rmsePlus, create);
+    bind("rmseMinus", &rmseMinus, create);
+    bind("signals", &signals, create);
+    bind("signalsError", &signals_sigma, create);
+    bind("signalsSynthetic", &signalResult, create);
+    bind("workSignal", &work_signal, create);
+
+    nShots = 0;
+    return true;
+}
+
+bool ResultTree::add(int shot, const rarray &pages)
+{
+    if (tree == nullptr)
+        return false;
+
+    this->shot = shot;
+    for (uint i = 0; i < pages.size(); i++)
+    {
+        const PageResult &page = pages[i];
+        sp = i / N_TIME_LIST;
+        it = i % N_TIME_LIST;
+        time_point = page.time_point;
+        x_position = page.x_position;
+        energy = page.energy;
+        theta = page.theta;
+        Te = page.Te;
+        TeError = page.TeError;
+        ne = page.ne;
+        neError = page.neError;
+        rmse = page.rmse;
+        rmsePlus = page.rmsePlus;
+        rmseMinus = page.rmseMinus;
+        *signals = page.signals;
+        *signals_sigma = page.signals_sigma;
+        *signalResult = page.signalResult;
+        *work_signal = page.work_signal;
+
+        if (tree->Fill() < 0)
+        {
+            std::cerr << "ошибка записи выстрела " << shot << " в " << file->GetName() << "!\n";
+            return false;
+        }
+    }
+
+    nShots++;
+    if (autosave_shots != 0 && nShots % autosave_shots == 0)
+        tree->AutoSave("SaveSelf"); // записанное не теряется при падении процесса
+
+    return true;
+}
+
+bool ResultTree::close()
+{
+    if (file == nullptr)
+        return false;
+
+    file->cd();
+    bool success = tree->Write("", TObject::kOverwrite) > 0;
+    file->Close(); // tree удаляется вместе с файлом
+    delete file;
+    file = nullptr;
+    tree = nullptr;
+
+    return success;
+}
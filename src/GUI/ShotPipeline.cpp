@@ -0,0 +1,1062 @@
+#include "ShotPipeline.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <set>
+#include <thread>
+#include <atomic>
+#include <cmath>
+#include <algorithm>
+
+#include <dasarchive/service.h>
+#include <dasarchive/TSignal.h>
+#include <dasarchive/TSignalF.h>
+#include <dasarchive/TSignalC.h>
+#include <TROOT.h>
+#include <TSystem.h>
+
+#include "thomsonCounter/BoundedQueue.h"
+#include "thomsonCounter/FastMath.h"
+#include "thomsonCounter/SRF.h"
+
+// калибровка записана X THETA COEFF
+#define ID_X 0
+#define ID_THETA 1
+#define ID_N_COEFF_CHANNEL_0 2
+#define ID_N_COEFF_CHANNEL_1 3
+#define ID_N_ADD_ENERGY 1
+
+void ShotItem::clear()
+{
+    spArray.clear();
+    counterArray.clear();
+    if (arena && pool != nullptr)
+        pool->release(arena.release());
+    arena.reset();
+    t.clear();
+    U.clear();
+    pages.clear();
+}
+
+ShotPipeline::ShotPipeline(const char *KUST_NAME, const char *CALIBRATION_NAME,
+                double LAMBDA_REFERENCE, uint N_TIME_SIZE, uint UNUSEFULL,
+                uint N_TIME_LIST, uint N_SPECTROMETERS, uint N_CHANNELS,
+                uint NUMBER_ENERGY_SPECTROMETER, uint NUMBER_ENERGY_CHANNEL,
+                uint N_SPECTROMETER_CALIBRATIONS, uint N_WORK_CHANNELS) :
+    KUST_NAME(KUST_NAME), CALIBRATION_NAME(CALIBRATION_NAME), LAMBDA_REFERENCE(LAMBDA_REFERENCE),
+    N_TIME_SIZE(N_TIME_SIZE), UNUSEFULL(UNUSEFULL), N_TIME_LIST(N_TIME_LIST),
+    N_SPECTROMETERS(N_SPECTROMETERS), N_CHANNELS(N_CHANNELS),
+    NUMBER_ENERGY_SPECTROMETER(NUMBER_ENERGY_SPECTROMETER), NUMBER_ENERGY_CHANNEL(NUMBER_ENERGY_CHANNEL),
+    N_SPECTROMETER_CALIBRATIONS(N_SPECTROMETER_CALIBRATIONS), N_WORK_CHANNELS(N_WORK_CHANNELS), calibrationIndex(CALIBRATION_NAME)
+{
+}
+
+TString ShotPipeline::getSignalName(uint nSpectrometer, uint nChannel) const
+{
+    return TString::Format("ts%u-f-ch%u", nSpectrometer+1, nChannel+1);
+}
+
+int &ShotPipeline::getShot(int &shot) const
+{
+    if (shot <= 0)
+        shot += GetLastShot();
+    return shot;
+}
+
+void ShotPipeline::readDataFromArchive(const char *archive_name, const char *kust, const char *signal_name, int shot, darray &t, darray &U, int timePoint, int timeList, const uint N_INFORM, const uint N_UNUSEFULL) const
+{
+    OpenArchive(archive_name);
+    readSignal(kust, signal_name, shot, t, U, timePoint, timeList, N_INFORM, N_UNUSEFULL);
+    CloseArchive();
+}
+
+void ShotPipeline::readSignal(const char *kust, const char *signal_name, int shot, darray &t, darray &U, int timePoint, int timeList, const uint N_INFORM, const uint N_UNUSEFULL) const
+{
+    const uint N_POINT = N_INFORM+N_UNUSEFULL;
+
+    shot = getShot(shot);
+
+    const uint tSize = N_INFORM / 2;
+
+    TSignal *signal = GetSignal(signal_name, kust, shot);
+
+    if (signal != nullptr)
+    {
+        if (timeList <= 0)
+            timeList = signal->GetSize() / (N_POINT);
+
+        if (timePoint < 0)
+        {
+            t.reserve(t.size()+tSize*N_TIME_LIST);
+            U.reserve(U.size()+tSize*N_TIME_LIST);
+        }
+        else
+        {
+            t.reserve(t.size()+tSize);
+            U.reserve(U.size()+tSize);
+        }
+
+        uint step = timePoint < 0. ? 0. : timePoint*N_POINT;
+
+        for (int it = std::max(0, timePoint); it < timeList; it++)
+        {
+            if (step >= signal->GetSize() || (it == timePoint+1 && timePoint >= 0))
+                break;
+
+            for (uint i = 0; i < tSize; i++)
+            {
+                if (timePoint < 0 || it == timePoint)
+                {
+                    t.push_back((*signal)[step]);
+                    U.push_back((*signal)[step+1]);
+                }
+
+                step += 2;
+            }
+
+            step += N_UNUSEFULL;
+        }
+    }
+    else
+    {
+        std::cout << "заполняем нулями\n";
+        timeList = N_TIME_LIST;
+        for (int it = std::max(0, timePoint); it < timeList; it++)
+        {
+            if ((it == timePoint+1 && timePoint >= 0))
+                break;
+
+            for (uint i = 0; i < tSize; i++)
+            {
+                if (timePoint < 0 || it == timePoint)
+                {
+                    t.push_back(0);
+                    U.push_back(0);
+                }
+            }
+        }
+    }
+
+    if (signal != nullptr)
+        delete signal;
+}
+
+darray ShotPipeline::readCalibration(const char *archive_name, const char *calibration_name, int shot) const
+{
+    darray calibration;
+
+    if (TFile *file=OpenArchive(archive_name))
+    {
+
+        getShot(shot);
+
+        TString shot_string = TString::Format("%d", shot);
+        TString shot_name = file->GetDirectory(shot_string) != nullptr ? GetShotCalibration(shot) : shot_string;
+
+        TSignalC *calibration_signal = nullptr;
+        calibration_signal = (TSignalC*) GetCalibration(calibration_name, shot_name);
+
+        if (calibration_signal != nullptr)
+        {
+            uint size = calibration_signal->GetSize()/sizeof(double);
+
+            calibration.reserve(size);
+
+            double *cal = reinterpret_cast<double*> (calibration_signal->GetArray());
+
+            for (uint i  = 0; i < size; i++)
+                calibration.push_back(cal[i]);
+        }
+
+        delete calibration_signal;
+
+    }
+
+    CloseArchive();
+
+    return calibration;
+}
+
+darray ShotPipeline::getCalibration(const char *archive_name, int shot, bool extra) const
+{
+    darray calibration;
+
+    if (shot <= 0)
+    {
+        OpenArchive(archive_name);
+        shot = getShot(shot);
+        CloseArchive();
+    }
+
+    if (!calibrationIndex.find(archive_name, shot, calibration)) // вне диапазонов индекса
+        calibration = readCalibration(archive_name, CALIBRATION_NAME, shot);
+
+    if (calibration.empty() && extra && !calibrationIndex.findLast(archive_name, calibration))
+    {
+        OpenArchive(archive_name);
+        int lastShotCal = GetLastShot()+1;
+        CloseArchive();
+        calibration = readCalibration(archive_name, CALIBRATION_NAME, lastShotCal);
+
+        if (calibration.empty())
+            calibration = readCalibration(archive_name, CALIBRATION_NAME, lastShotCal-1);
+    }
+
+    if (calibration.size() < N_SPECTROMETER_CALIBRATIONS*N_SPECTROMETERS+N_ADD_CALIBRATIONS)
+        calibration.resize(N_SPECTROMETERS*N_SPECTROMETER_CALIBRATIONS+N_ADD_CALIBRATIONS, 0);
+
+    return calibration;
+}
+
+bool ShotPipeline::isArchiveAvailable(const char *archive_name) const
+{
+    bool available = OpenArchive(archive_name) != nullptr;
+    CloseArchive();
+    return available;
+}
+
+darray ShotPipeline::createTimePointsArray(const std::string &archive_name, int shot) const
+{
+    darray time_points = readTimePoints(OpenArchive(archive_name.c_str()), shot);
+    CloseArchive();
+    return time_points;
+}
+
+darray ShotPipeline::readTimePoints(TFile *file, int shot) const
+{
+    darray time_points(N_TIME_LIST, 0.);
+
+    TDirectory *dir = file != nullptr ? file->GetDirectory(TString::Format("%d/MSE", shot)) : nullptr;
+    TSignal *signal = dir != nullptr ? (TSignal*) dir->FindObjectAny("ts_ref2") : nullptr;
+    if (signal == nullptr)
+        return time_points;
+
+    const uint size = signal->GetSize();
+    const double t0 = signal->GetXShift();
+    const double dt = signal->GetXQuant();
+    const double level = 0.2;
+
+    // маска порога строится блоками, передние фронты ищутся по ней без ветвлений;
+    // просмотр заканчивается на блоке с последним нужным фронтом, а не на конце сигнала
+    const uint BLOCK = 4096;
+    unsigned char above[BLOCK+1]; // above[i+1] - отсчет first+i выше порога
+    above[0] = 0; // до начала сигнала ниже порога
+
+    uint it = 1;
+    for (uint first = 0; first < size && it < N_TIME_LIST; first += BLOCK)
+    {
+        const uint n = std::min(BLOCK, size-first);
+        for (uint i = 0; i < n; i++)
+            above[i+1] = (*signal)[first+i] >= level;
+
+        const unsigned char *end = above+n;
+        for (const unsigned char *p = above; it < N_TIME_LIST; p++)
+        {
+            p = std::adjacent_find(p, end+1, [](unsigned char a, unsigned char b) { return a < b; });
+            if (p >= end)
+                break;
+            time_points[it] = (t0 + (first + (p-above))*dt)*1e-3;
+            it++;
+        }
+        above[0] = above[n]; // последний отсчет блока - предыдущий для следующего
+    }
+
+    return time_points;
+}
+
+uint64_t ShotPipeline::configurationHash(const std::string &srf_file_folder, const std::string &convolution_file_folder, const std::string &error_file_name,
+                                        const std::string &processing_parameters, const std::string *work_mask_string, int selectionMethod, bool count,
+                                        bool responseTables) const
+{
+    uint64_t hash = hashString(KUST_NAME);
+    for (uint sp = 0; sp < N_SPECTROMETERS; sp++)
+    {
+        hash = hashFile(srfFileName(srf_file_folder, sp), hash);
+        hash = hashFile(convolutionFileName(convolution_file_folder, sp), hash);
+        hash = hashString(work_mask_string[sp], hash);
+    }
+    hash = hashFile(error_file_name, hash);
+    hash = hashFile(processing_parameters, hash);
+
+    // шаблоны matched читаются из своих файлов, их правка тоже меняет результат
+    std::set <std::string> pulse_names;
+    for (const parray &parameters : readParametersToSignalProcessing(processing_parameters))
+        for (const SignalProcessingParameters &p : parameters)
+            if (p.pulse)
+                pulse_names.insert(p.pulse->getName());
+    for (const std::string &name : pulse_names)
+        hash = hashFile(name, hash); // ширина гауссова шаблона уже в файле параметров, файла с таким именем нет
+
+    hash = hashBytes(&selectionMethod, sizeof(selectionMethod), hash);
+    hash = hashBytes(&count, sizeof(count), hash);
+    if (responseTables) // без таблиц ключ как раньше, старый кэш остается действительным
+        hash = hashString("response", hash);
+    int tier = getExpTier();
+    if (tier != EXP_STD) // приближенный exp меняет результаты на уровне своей ошибки
+        hash = hashBytes(&tier, sizeof(tier), hash);
+    hash = hashBytes(&LAMBDA_REFERENCE, sizeof(LAMBDA_REFERENCE), hash);
+    double tolerance = SRF_BAND_TOLERANCE; // края SRF отбрасываются по этой доле, спектр и свертка считаются только в полосе
+    hash = hashBytes(&tolerance, sizeof(tolerance), hash);
+    uint sample_size = sizeof(sample_t); // сигналы с float-отсчетами отличаются на уровне округления
+    hash = hashBytes(&sample_size, sizeof(sample_size), hash);
+
+    return hash;
+}
+
+uint64_t ShotPipeline::signalHash(const ShotSettings &settings, int shot) const
+{
+    uint64_t hash = hashString(settings.archive_name, hashString(KUST_NAME));
+    hash = hashBytes(&shot, sizeof(shot), hash);
+
+    for (const parray &parameters : settings.parametersArray)
+    {
+        for (const SignalProcessingParameters &p : parameters) // поля по отдельности, без байтов выравнивания
+        {
+            darray values = {(double) p.start_point_from_start_zero_line, (double) p.start_point_from_end_zero_line,
+                             (double) p.step_from_start_zero_line, (double) p.step_from_end_zero_line,
+                             (double) p.signal_point_start, (double) p.signal_point_step, (double) p.point_integrate_start,
+                             p.threshold, (double) p.increase_point, (double) p.decrease_point, p.klim,
+                             (double) p.detector, p.snr_min};
+            hash = hashArray(values, hash);
+            if (p.pulse)
+                hash = hashArray(p.pulse->getShape(), hash);
+        }
+    }
+
+    for (const std::pair<double, double> &sigma : settings.sigmaCoeff)
+        hash = hashArray({sigma.first, sigma.second}, hash);
+
+    for (const barray &mask : settings.work_mask)
+    {
+        std::string bits;
+        for (bool b : mask)
+            bits += b ? '1' : '0';
+        hash = hashString(bits, hash);
+    }
+
+    return hash;
+}
+
+uint64_t ShotPipeline::tablesHash(const ShotSettings &settings) const
+{
+    uint64_t hash = hashString(KUST_NAME);
+    for (uint sp = 0; sp < N_SPECTROMETERS; sp++)
+    {
+        hash = hashFile(srfFileName(settings.srf_file_folder, sp), hash);
+        hash = hashFile(convolutionFileName(settings.convolution_file_folder, sp), hash);
+    }
+    if (settings.responseTables)
+        hash = hashString("response", hash);
+    return hash;
+}
+
+bool ShotPipeline::getline(std::ifstream &fin, std::string &line, char comment) const
+{
+    while (std::getline(fin, line))
+    {
+        if (line.size() != 0 && line[0] != comment)    
+            return true;
+    }
+    
+    return false;
+}
+
+void ShotPipeline::readError(const char *file_name, std::vector<std::pair<double, double>> &sigmaCoeff) const
+{
+
+    sigmaCoeff.clear();
+    sigmaCoeff.resize(N_CHANNELS*N_SPECTROMETERS, std::pair<double, double> (0, 0));
+
+
+    std::ifstream fin;
+    fin.open(file_name);
+
+    if (fin.is_open())
+    {
+        for (uint i = 0; i < N_CHANNELS*N_SPECTROMETERS; i++)
+            fin >> sigmaCoeff[i].first;
+
+        for (uint i = 0; i < N_CHANNELS*N_SPECTROMETERS; i++)
+            fin >> sigmaCoeff[i].second;
+
+    }   
+    else
+    {
+        std::cerr << "не удалось прочитать файл error\n";
+    }
+
+    fin.close();
+
+}
+
+barray ShotPipeline::createWorkMask(const std::string &work_mask_string) const
+{
+    barray work_mask(N_CHANNELS, false);
+
+    for (uint i = 0; i < std::min((uint) work_mask_string.size(), N_WORK_CHANNELS); i++)
+        work_mask[i] = work_mask_string[i] == '+' ? true : false;
+
+    return work_mask;
+}
+
+std::vector<parray> ShotPipeline::readParametersToSignalProcessing(const std::string &file_name) const
+{
+    std::vector <parray> parametersArray(N_SPECTROMETERS, parray(N_CHANNELS));
+    std::map <std::string, std::shared_ptr<const PulseTemplate>> pulses; // один шаблон на все каналы с ним
+
+    std::ifstream fin;
+    fin.open(file_name);
+    if (fin.is_open())
+    {
+        std::string line;
+        for (uint sp = 0; sp < N_SPECTROMETERS; sp++)
+        {
+            fin >> line;
+            for (uint ch = 0; ch < N_CHANNELS; ch++)
+            {
+
+                SignalProcessingParameters pr;
+
+                fin >> line >> pr.start_point_from_start_zero_line >> pr.step_from_start_zero_line >>
+                pr.start_point_from_end_zero_line >> pr.step_from_end_zero_line
+                >> pr.signal_point_start >> pr.signal_point_step >> pr.point_integrate_start >>
+                pr.threshold >> pr.increase_point >> pr.decrease_point >> pr.klim;
+
+                // необязательный конец строки: matched <snr_min> <ширина шаблона в точках | файл шаблона>
+                std::string rest;
+                std::getline(fin, rest);
+                std::istringstream sin(rest);
+                std::string detector;
+                if (sin >> detector && detector == "matched")
+                {
+                    std::string pulse_name;
+                    if (sin >> pr.snr_min >> pulse_name)
+                    {
+                        if (pulses.find(pulse_name) == pulses.end())
+                        {
+                            char *end = nullptr;
+                            double width = strtod(pulse_name.c_str(), &end);
+                            darray shape;
+                            std::shared_ptr <PulseTemplate> pulse;
+                            if (*end == '\0')
+                                pulse = std::make_shared<PulseTemplate>(PulseTemplate::gaussian(width));
+                            else if (readPulseTemplate(pulse_name, shape))
+                                pulse = std::make_shared<PulseTemplate>(shape);
+                            if (pulse)
+                                pulse->setName(pulse_name);
+                            pulses[pulse_name] = pulse;
+                        }
+                        pr.pulse = pulses[pulse_name];
+                        pr.detector = pr.pulse ? DETECTOR_MATCHED : DETECTOR_THRESHOLD;
+                    }
+                    else
+                        std::cerr << "sp " << sp << " ch " << ch << ": для matched нужны snr_min и шаблон импульса!\n";
+                }
+                else if (!detector.empty() && detector != "threshold")
+                    std::cerr << "sp " << sp << " ch " << ch << ": неизвестный способ поиска импульса " << detector << "!\n";
+
+                parametersArray[sp][ch] = pr;
+            }
+        }
+    }
+    else {
+        std::cerr << "не удалось открыть файл с параметрами: " << file_name  << "!\n";
+    }
+    fin.close();
+
+    return parametersArray;
+}
+
+bool ShotPipeline::writeParametersToSignalProcessing(const std::string &file_name, const std::vector<parray> &parametersArray) const
+{
+    std::ofstream fout(file_name);
+    if (!fout.is_open())
+    {
+        std::cerr << "не удалось открыть файл для записи параметров: " << file_name << "!\n";
+        return false;
+    }
+
+    fout.precision(10);
+    for (uint sp = 0; sp < parametersArray.size(); sp++)
+    {
+        fout << "sp" << sp << "\n";
+        for (uint ch = 0; ch < parametersArray[sp].size(); ch++)
+        {
+            const SignalProcessingParameters &pr = parametersArray[sp][ch];
+            fout << "\tch" << ch << "\t" << pr.start_point_from_start_zero_line << " " << pr.step_from_start_zero_line << " "
+                 << pr.start_point_from_end_zero_line << " " << pr.step_from_end_zero_line << " ";
+            if (pr.signal_point_start == (uint)-1) // адаптивные параметры
+                fout << -1;
+            else
+                fout << pr.signal_point_start;
+            fout << " " << pr.signal_point_step << " " << pr.point_integrate_start << " "
+                 << pr.threshold << " " << pr.increase_point << " " << pr.decrease_point << " " << pr.klim;
+            if (pr.detector == DETECTOR_MATCHED && pr.pulse)
+                fout << " matched " << pr.snr_min << " " << pr.pulse->getName();
+            fout << "\n";
+        }
+    }
+
+    fout.close();
+    return !fout.fail();
+}
+
+bool ShotPipeline::readFileInput( std::ifstream &fin,
+    std::string &srf_file_folder, std::string &convolution_file_folder, 
+    std::string &raman_file_name, std::string &archive_file_name, std::string &error_file_name,
+    std::string *work_mask_string, std::string &processing_parameters, int &type) const
+{
+    getline(fin, srf_file_folder);
+    getline(fin, convolution_file_folder);
+    getline(fin, raman_file_name);
+    getline(fin, archive_file_name);
+    getline(fin, error_file_name);
+
+    if (work_mask_string != nullptr)
+        for (uint i = 0; i < N_SPECTROMETERS; i++)
+            getline(fin, work_mask_string[i]);
+    else
+    {
+        std::string temp;
+        for (uint i = 0; i < N_SPECTROMETERS; i++)
+            getline(fin, temp);
+    }
+
+    getline(fin, processing_parameters);
+    fin >> type;
+    return fin.fail();
+}
+
+bool ShotPipeline::createSettings(const std::string &file_name, ShotSettings &settings, bool useCache) const
+{
+    std::ifstream fin;
+    fin.open(file_name);
+    if (!fin.is_open())
+    {
+        std::cerr << "не удалось открыть файл: " << file_name << "!\n";
+        return false;
+    }
+
+    std::string raman_file_name;
+    std::string error_file_name;
+    std::vector <std::string> work_mask_string(N_SPECTROMETERS);
+    std::string processing_parameters;
+    int type;
+
+    if (readFileInput(fin, settings.srf_file_folder, settings.convolution_file_folder, raman_file_name, settings.archive_name,
+                      error_file_name, work_mask_string.data(), processing_parameters, type))
+    {
+        std::cerr << "не удалось прочитать файл: " << file_name << "!\n";
+        return false;
+    }
+    fin.close();
+
+    readError(error_file_name.c_str(), settings.sigmaCoeff);
+    settings.parametersArray = readParametersToSignalProcessing(processing_parameters);
+    settings.work_mask.clear();
+    for (uint sp = 0; sp < N_SPECTROMETERS; sp++)
+        settings.work_mask.push_back(createWorkMask(work_mask_string[sp]));
+    settings.selectionMethod = type;
+    settings.count = true;
+    settings.snapshot_folder.clear(); // снимки только по явному запросу
+    settings.calibrations.clear();
+    settings.configHash = useCache ? configurationHash(settings.srf_file_folder, settings.convolution_file_folder, error_file_name,
+                                                       processing_parameters, work_mask_string.data(), type, true) : 0;
+
+    return true;
+}
+
+rarray ShotPipeline::createPages(const ShotItem &item) const
+{
+    rarray pages(N_SPECTROMETERS*N_TIME_LIST);
+    for (uint i = 0; i < pages.size(); i++)
+    {
+        const SignalProcessing *signalProcessing = item.spArray[i];
+        const ThomsonCounter *counter = item.counterArray[i];
+        PageResult &page = pages[i];
+
+        page.signals = signalProcessing->getSignals();
+        page.signals_sigma = signalProcessing->getSignalsSigma();
+        page.work_signal = signalProcessing->getWorkSignals();
+        page.coeff_to_energy = signalProcessing->getCoeffToEnergy();
+
+        page.theta = counter->getTheta();
+        page.Ki = counter->getKi();
+        page.energy = counter->getEnergy();
+        page.time_point = counter->getTimePoint();
+        page.x_position = counter->getXPositon();
+
+        page.Te = counter->getT();
+        page.TeError = counter->getTError();
+        page.ne = counter->getN();
+        page.neError = counter->getNError();
+        page.rmse = counter->getRMSE();
+        page.rmsePlus = counter->getRMSEPlus();
+        page.rmseMinus = counter->getRMSEMinus();
+
+        page.signalResult = counter->getSignalResult();
+        page.signalResultPlus = counter->getSignalResultPlus();
+        page.signalResultMinus = counter->getSignalResultMinus();
+    }
+
+    return pages;
+}
+
+bool ShotPipeline::readSnapshot(const ShotSettings &settings, ShotItem &item, darray &calibrations) const
+{
+    ShotSnapshot snapshot;
+    if (settings.snapshot_folder.empty() ||
+        !readShotSnapshot(snapshotFileName(settings.snapshot_folder, item.shot), snapshot, settings.archive_name, N_TIME_LIST, N_SPECTROMETERS, N_CHANNELS, N_TIME_SIZE))
+        return false;
+
+    if (snapshot.shot != item.shot)
+    {
+        std::cerr << "снимок выстрела " << item.shot << " записан для выстрела " << snapshot.shot << ", чтение из архива\n";
+        return false;
+    }
+
+    calibrations.swap(snapshot.calibrations);
+    item.time_points.swap(snapshot.time_points);
+    item.t.swap(snapshot.t);
+    item.U.swap(snapshot.U);
+    return true;
+}
+
+bool ShotPipeline::exportSnapshots(const ShotSettings &settings, const uiarray &shots, const std::string &snapshot_folder) const
+{
+    ShotSettings archiveSettings = settings; // без кэша и старых снимков
+    archiveSettings.configHash = 0;
+    archiveSettings.snapshot_folder.clear();
+
+    gSystem->mkdir(snapshot_folder.c_str(), kTRUE);
+
+    bool success = true;
+    for (uint shot : shots)
+    {
+        ShotItem item;
+        item.shot = shot;
+        readShot(archiveSettings, item);
+
+        ShotSnapshot snapshot;
+        snapshot.shot = shot;
+        snapshot.archive_name = settings.archive_name;
+        snapshot.N_TIME_LIST = N_TIME_LIST;
+        snapshot.N_SPECTROMETERS = N_SPECTROMETERS;
+        snapshot.N_CHANNELS = N_CHANNELS;
+        snapshot.N_TIME_SIZE = N_TIME_SIZE;
+        snapshot.calibrations.swap(item.calibrations);
+        snapshot.time_points.swap(item.time_points);
+        snapshot.t.swap(item.t);
+        snapshot.U.swap(item.U);
+
+        if (writeShotSnapshot(snapshotFileName(snapshot_folder, shot), snapshot))
+            std::cout << "shot " << shot << " записан в " << snapshotFileName(snapshot_folder, shot) << "\n";
+        else
+            success = false;
+    }
+
+    return success;
+}
+
+bool ShotPipeline::tuneParameters(const ShotSettings &settings, const uiarray &shots, const TuneGrid &grid, std::vector<parray> &parametersArray) const
+{
+    ShotSettings rawSettings = settings; // сырые страницы, без кэша результатов
+    rawSettings.configHash = 0;
+
+    const parray &energyParameters = settings.parametersArray[NUMBER_ENERGY_SPECTROMETER];
+    const barray &energyMask = settings.work_mask[NUMBER_ENERGY_SPECTROMETER];
+
+    // сигналы всех выстрелов читаются один раз, энергия лазера - с текущими параметрами
+    std::vector <ShotItem> items(shots.size());
+    darray energy; // it+N_TIME_LIST*index
+    uint nSamples = 0;
+    for (uint i = 0; i < shots.size(); i++)
+    {
+        items[i].shot = shots[i];
+        items[i].index = i;
+        readShot(rawSettings, items[i]);
+
+        for (uint it = 0; it < N_TIME_LIST; it++)
+        {
+            double E = 0.;
+            if (items[i].t.size() == N_SPECTROMETERS*N_TIME_LIST)
+            {
+                uint page = it+NUMBER_ENERGY_SPECTROMETER*N_TIME_LIST;
+                SignalProcessing sp(items[i].t[page], items[i].U[page], N_CHANNELS, energyParameters, settings.sigmaCoeff, energyMask);
+                if (sp.getWorkSignals()[NUMBER_ENERGY_CHANNEL])
+                    E = sp.getSignals()[NUMBER_ENERGY_CHANNEL];
+            }
+            energy.push_back(E);
+            if (E > 0.)
+                nSamples++;
+        }
+    }
+
+    if (nSamples == 0)
+    {
+        std::cerr << "нет страниц с импульсом лазера для подбора параметров!\n";
+        return false;
+    }
+
+    parametersArray = settings.parametersArray;
+    std::vector <TuneResult> results(N_SPECTROMETERS*N_CHANNELS);
+    uiarray tuned(N_SPECTROMETERS*N_CHANNELS, 0); // не barray - пишется из разных потоков
+
+    // каналы подбираются параллельно, у каждого потока свой ParameterTuner
+    std::atomic <uint> next(0);
+    auto worker = [&]() {
+        for (uint index = next++; index < N_SPECTROMETERS*N_CHANNELS; index = next++)
+        {
+            uint sp = index / N_CHANNELS;
+            uint ch = index % N_CHANNELS;
+            const SignalProcessingParameters &start = settings.parametersArray[sp][ch];
+            if ((sp == NUMBER_ENERGY_SPECTROMETER && ch == NUMBER_ENERGY_CHANNEL) || !settings.work_mask[sp][ch] || start.signal_point_start == (uint)-1)
+                continue;
+
+            ParameterTuner tuner(N_TIME_SIZE, nSamples);
+            for (uint i = 0; i < items.size(); i++)
+            {
+                if (items[i].t.size() != N_SPECTROMETERS*N_TIME_LIST)
+                    continue;
+                for (uint it = 0; it < N_TIME_LIST; it++)
+                {
+                    const uint page = it+sp*N_TIME_LIST;
+                    if (energy[it+N_TIME_LIST*i] > 0. && items[i].t[page].size() >= (ch+1)*N_TIME_SIZE)
+                        tuner.addSample(items[i].t[page].data()+ch*N_TIME_SIZE, items[i].U[page].data()+ch*N_TIME_SIZE, energy[it+N_TIME_LIST*i]);
+                }
+            }
+
+            results[index] = tuner.tune(start, settings.sigmaCoeff[ch], grid);
+            parametersArray[sp][ch] = results[index].parameters;
+            tuned[index] = 1;
+        }
+    };
+
+    uint n_threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector <std::thread> threads;
+    for (uint i = 0; i < n_threads; i++)
+        threads.emplace_back(worker);
+    for (std::thread &thread : threads)
+        thread.join();
+
+    for (uint index = 0; index < results.size(); index++)
+        if (tuned[index])
+            std::cout << "sp " << index / N_CHANNELS << " ch " << index % N_CHANNELS << ": " << results[index].startScore << " -> " << results[index].score
+                      << " (" << results[index].settings << " наборов, " << nSamples << " страниц)\n";
+
+    return true;
+}
+
+void ShotPipeline::readShot(const ShotSettings &settings, ShotItem &item) const
+{
+    const char *archive_name = settings.archive_name.c_str();
+
+    // калибровки всегда из архива (после WriteCalibration те же, что у refitShot), калибровки снимка - только без архива,
+    // тогда снимок читается до кэша, иначе только если выстрела нет в кэше
+    bool fromSnapshot = false;
+    if (!settings.calibrations.empty())
+        item.calibrations = settings.calibrations;
+    else if (settings.snapshot_folder.empty() || isArchiveAvailable(archive_name))
+        item.calibrations = getCalibration(archive_name, item.shot, true);
+    else if ((fromSnapshot = readSnapshot(settings, item, item.calibrations)))
+        std::cout << "shot " << item.shot << ": архив недоступен, калибровки из снимка\n";
+    else
+        item.calibrations = getCalibration(archive_name, item.shot, true);
+
+    if (settings.configHash != 0)
+    {
+        item.key = shotCacheKey(settings.configHash, settings.archive_name, item.calibrations);
+        if (readShotCache(settings.cache_folder, item.shot, item.key, item.pages) && item.pages.size() == N_SPECTROMETERS*N_TIME_LIST)
+        {
+            item.cached = true;
+            std::cout << "shot " << item.shot << " загружен из кэша\n";
+            return;
+        }
+        item.pages.clear();
+    }
+
+    darray calibrations; // калибровки снимка не нужны, уже выбраны выше
+    if (fromSnapshot || readSnapshot(settings, item, calibrations))
+        return;
+
+    // время лазерных импульсов и все сигналы выстрела читаются за одно открытие архива
+    TFile *file = OpenArchive(archive_name);
+    item.time_points = readTimePoints(file, item.shot);
+
+    item.t.assign(N_SPECTROMETERS*N_TIME_LIST, sarray());
+    item.U.assign(N_SPECTROMETERS*N_TIME_LIST, sarray());
+    for (uint i = 0; i < item.t.size(); i++)
+    {
+        item.t[i].reserve(N_TIME_SIZE*N_CHANNELS);
+        item.U[i].reserve(N_TIME_SIZE*N_CHANNELS);
+    }
+
+    darray t;
+    darray U;
+    for (uint sp = 0; sp < N_SPECTROMETERS; sp++)
+    {
+        for (uint ch = 0; ch < N_CHANNELS; ch++)
+        {
+            // сигнал канала читается один раз для всех страниц
+            TString signal_name = getSignalName(sp, ch);
+            t.clear();
+            U.clear();
+            readSignal(KUST_NAME, signal_name, item.shot, t, U, -1, 0, N_TIME_SIZE*2, UNUSEFULL);
+
+            for (uint it = 0; it < N_TIME_LIST; it++)
+            {
+                sarray &tPage = item.t[it+sp*N_TIME_LIST];
+                sarray &UPage = item.U[it+sp*N_TIME_LIST];
+                if (t.size() >= (it+1)*N_TIME_SIZE)
+                {
+                    tPage.insert(tPage.end(), t.begin()+it*N_TIME_SIZE, t.begin()+(it+1)*N_TIME_SIZE);
+                    UPage.insert(UPage.end(), U.begin()+it*N_TIME_SIZE, U.begin()+(it+1)*N_TIME_SIZE);
+                }
+                else
+                {
+                    std::cout << "shot " << item.shot << " sp " << sp << " tp " << it << " заполнена нулями\n";
+                    tPage.insert(tPage.end(), N_TIME_SIZE, 0.);
+                    UPage.insert(UPage.end(), N_TIME_SIZE, 0.);
+                }
+            }
+        }
+    }
+
+    CloseArchive();
+}
+
+void ShotPipeline::processShot(const ShotSettings &settings, ShotItem &item) const
+{
+    if (!item.arena)
+    {
+        item.arena.reset(arenaPool.acquire());
+        item.pool = &arenaPool;
+    }
+
+    item.spArray.reserve(N_SPECTROMETERS*N_TIME_LIST);
+
+    for (uint sp = 0; sp < N_SPECTROMETERS; sp++)
+    {
+        for (uint it = 0; it < N_TIME_LIST; it++)
+        {
+            uint index = it+sp*N_TIME_LIST;
+            if (item.cached)
+            {
+                const PageResult &page = item.pages[index];
+                item.spArray.push_back(item.arena->createSignalProcessing(page.signals, page.signals_sigma, page.work_signal, page.coeff_to_energy));
+            }
+            else
+            {
+                item.spArray.push_back(item.arena->createSignalProcessing(item.t[index], item.U[index], N_CHANNELS, settings.parametersArray[sp], settings.sigmaCoeff, settings.work_mask[sp]));
+                sarray().swap(item.t[index]); // осциллограммы скопированы в SignalProcessing
+                sarray().swap(item.U[index]);
+            }
+        }
+    }
+
+    item.t.clear();
+    item.U.clear();
+
+    if (!item.cached)
+    {
+        double coeff_to_energy = item.calibrations[N_SPECTROMETER_CALIBRATIONS*N_SPECTROMETERS-1+ID_N_ADD_ENERGY];
+        for (uint it = 0; it < N_TIME_LIST; it++)
+            item.spArray[it+NUMBER_ENERGY_SPECTROMETER*N_TIME_LIST]->setCoeffToEnergy(coeff_to_energy);
+    }
+}
+
+void ShotPipeline::fitShot(const ShotSettings &settings, ShotItem &item) const
+{
+    item.counterArray.reserve(N_SPECTROMETERS*N_TIME_LIST);
+
+    const darray &calibrations = item.calibrations;
+
+    for (uint sp = 0; sp < N_SPECTROMETERS; sp++)
+    {
+        std::string srf_file_name = srfFileName(settings.srf_file_folder, sp);
+        std::string convolution_file_name = convolutionFileName(settings.convolution_file_folder, sp);
+
+        darray Ki(N_CHANNELS, calibrations[sp*N_SPECTROMETER_CALIBRATIONS+ID_N_COEFF_CHANNEL_1]);
+        double x_positon = -calibrations[sp*N_SPECTROMETER_CALIBRATIONS+ID_X]/10.;
+
+        // таблица строится один раз на файл SRF, дальше читается из cache_folder
+        std::shared_ptr <const ResponseTable> response;
+        if (settings.responseTables && !item.cached)
+        {
+            gSystem->mkdir(settings.cache_folder.c_str(), kTRUE);
+            response = ResponseTable::get(srf_file_name, N_CHANNELS, LAMBDA_REFERENCE, settings.cache_folder);
+        }
+
+        // нет файла свертки - свертка по SRF для theta спектрометра, новая при смене SRF или theta
+        std::shared_ptr <const ConvolutionTable> convolution;
+        if (!item.cached && !std::ifstream(convolution_file_name).good())
+        {
+            gSystem->mkdir(settings.cache_folder.c_str(), kTRUE);
+            convolution = ConvolutionTable::get(srf_file_name, N_CHANNELS, calibrations[sp*N_SPECTROMETER_CALIBRATIONS+ID_THETA], LAMBDA_REFERENCE,
+                                                settings.cache_folder);
+        }
+
+        for (uint it = 0; it < N_TIME_LIST; it++)
+        {
+            const SignalProcessing &signalProcessing = *item.spArray[it+sp*N_TIME_LIST];
+            ThomsonCounter *counter = nullptr;
+
+            if (item.cached)
+            {
+                const PageResult &page = item.pages[it+sp*N_TIME_LIST];
+                counter = item.arena->createThomsonCounter(N_CHANNELS, srf_file_name, convolution_file_name, signalProcessing, page.theta, page.Ki,
+                                            darray(N_CHANNELS, 0), page.energy, 0, page.time_point, page.x_position, LAMBDA_REFERENCE, settings.selectionMethod);
+                counter->setResult(page.Te, page.TeError, page.ne, page.neError, page.rmse, page.rmsePlus, page.rmseMinus,
+                                   page.signalResult, page.signalResultPlus, page.signalResultMinus);
+            }
+            else
+            {
+                double energy = item.spArray[it+NUMBER_ENERGY_SPECTROMETER*N_TIME_LIST]->getSignals()[NUMBER_ENERGY_CHANNEL];
+                counter = item.arena->createThomsonCounter(N_CHANNELS, srf_file_name, convolution_file_name, signalProcessing, calibrations[sp*N_SPECTROMETER_CALIBRATIONS+ID_THETA], Ki,
+                                            darray(N_CHANNELS, 0), energy, 0, item.time_points[it], x_positon, LAMBDA_REFERENCE, settings.selectionMethod);
+                counter->setConvolution(convolution);
+                counter->setResponseTable(response);
+
+                if (settings.count)
+                {
+                    counter->count();
+                    counter->countConcentration();
+                    counter->countSignalResult();
+                }
+            }
+
+            item.counterArray.push_back(counter);
+        }
+    }
+
+    if (item.cached)
+    {
+        item.pages.clear();
+        return;
+    }
+
+    if (item.key != 0)
+    {
+        gSystem->mkdir(settings.cache_folder.c_str(), kTRUE);
+        writeShotCache(settings.cache_folder, item.shot, item.key, createPages(item));
+    }
+}
+
+void ShotPipeline::countShot(const ShotSettings &settings, int shot, ShotItem &item) const
+{
+    item.clear();
+    arenaPool.clear(); // файлы SRF могли измениться с прошлого счета
+    item.shot = shot;
+    item.cached = false;
+    item.key = 0;
+
+    readShot(settings, item);
+    processShot(settings, item);
+    fitShot(settings, item);
+}
+
+void ShotPipeline::refitShot(const ShotSettings &settings, ShotItem &item) const
+{
+    item.calibrations = settings.calibrations.empty() ? getCalibration(settings.archive_name.c_str(), item.shot, true) : settings.calibrations;
+    item.key = settings.configHash != 0 ? shotCacheKey(settings.configHash, settings.archive_name, item.calibrations) : 0;
+    item.cached = false;
+
+    item.time_points.assign(N_TIME_LIST, 0.);
+    for (uint it = 0; it < N_TIME_LIST; it++)
+        item.time_points[it] = item.counterArray[it+NUMBER_ENERGY_SPECTROMETER*N_TIME_LIST]->getTimePoint();
+
+    double coeff_to_energy = item.calibrations[N_SPECTROMETER_CALIBRATIONS*N_SPECTROMETERS-1+ID_N_ADD_ENERGY];
+    for (uint it = 0; it < N_TIME_LIST; it++)
+        item.spArray[it+NUMBER_ENERGY_SPECTROMETER*N_TIME_LIST]->setCoeffToEnergy(coeff_to_energy);
+
+    // ThomsonCounter используются заново, SRF и свертка не перечитываются если файлы те же
+    item.counterArray.clear();
+    item.arena->resetThomsonCounters();
+    fitShot(settings, item);
+}
+
+bool ShotPipeline::run(const ShotSettings &settings, const uiarray &shots, uint queue_depth, const std::function<bool(ShotItem &)> &consumer) const
+{
+    ROOT::EnableThreadSafety();
+    arenaPool.clear();
+
+    BoundedQueue <ShotItem> readQueue(queue_depth);
+    BoundedQueue <ShotItem> processQueue(queue_depth);
+    BoundedQueue <ShotItem> fitQueue(queue_depth);
+
+    // чтение следующего выстрела идет пока предыдущий обрабатывается и фитируется
+    std::thread reader([&]() {
+        for (uint i = 0; i < shots.size(); i++)
+        {
+            ShotItem item;
+            item.shot = shots[i];
+            item.index = i;
+            readShot(settings, item);
+            if (!readQueue.push(std::move(item)))
+            {
+                item.clear();
+                break;
+            }
+        }
+        readQueue.close();
+    });
+
+    std::thread processor([&]() {
+        ShotItem item;
+        while (readQueue.pop(item))
+        {
+            processShot(settings, item);
+            if (!processQueue.push(std::move(item)))
+            {
+                item.clear();
+                break;
+            }
+        }
+        processQueue.close();
+    });
+
+    std::thread fitter([&]() {
+        ShotItem item;
+        while (processQueue.pop(item))
+        {
+            fitShot(settings, item);
+            if (!fitQueue.push(std::move(item)))
+            {
+                item.clear();
+                break;
+            }
+        }
+        fitQueue.close();
+    });
+
+    bool complete = true;
+    ShotItem item;
+    while (fitQueue.pop(item))
+    {
+        bool next = consumer(item);
+        item.clear(); // объекты, не забранные consumer
+        if (!next)
+        {
+            complete = false;
+            readQueue.close();
+            processQueue.close();
+            fitQueue.close();
+            break;
+        }
+    }
+
+    reader.join();
+    processor.join();
+    fitter.join();
+
+    // после остановки в очередях могли остаться выстрелы
+    while (readQueue.pop(item))
+        item.clear();
+    while (processQueue.pop(item))
+        item.clear();
+    while (fitQueue.pop(item))
+        item.clear();
+
+    return complete;
+}
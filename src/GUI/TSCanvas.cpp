@@ -23,47 +23,144 @@ void TSCanvas::ExecuteEvent(Int_t event, Int_t px, Int_t py)
     if (last_slider_point == nPoint)
         return;
 
+    drawPage(nPoint);
+}
+
+void TSCanvasPage::clear()
+{
+    for (TMultiGraph *mg : mgArray)
+    {
+        GraphPool::release(mg);
+        delete mg;
+    }
+    for (THStack *hs : hsArray)
+    {
+        GraphPool::release(hs);
+        delete hs;
+    }
+    for (TLegend *leg : legendArray)
+        delete leg;
+    for (TLatex *tex : textArray)
+        delete tex;
+
+    mgArray.clear();
+    hsArray.clear();
+    legendArray.clear();
+    textArray.clear();
+    built = false;
+}
+
+void TSCanvas::setPageBuilder(const TSPageBuilder &pageBuilder, uint max_pages)
+{
+    for (TSCanvasPage &page : pages)
+        page.clear();
+    lastPages.clear();
+
+    this->pageBuilder = pageBuilder;
+    this->max_pages = max_pages == 0 ? 1 : max_pages;
+    pages.assign(slider_points, TSCanvasPage());
+}
+
+TSCanvasPage *TSCanvas::getPage(int nPoint)
+{
+    if (nPoint < 0 || nPoint >= (int) pages.size())
+        return nullptr;
+
+    TSCanvasPage &page = pages[nPoint];
+    if (page.built)
+    {
+        lastPages.remove(nPoint);
+        lastPages.push_front(nPoint);
+        return &page;
+    }
+
+    if (!pageBuilder)
+        return &page;
+
+    pageBuilder(nPoint, page);
+    for (TMultiGraph *mg : page.mgArray)
+        if (mg)
+            mg->ResetBit(kCanDelete);
+    for (THStack *hs : page.hsArray)
+        if (hs)
+            hs->ResetBit(kCanDelete);
+    for (TLegend *leg : page.legendArray)
+        if (leg)
+            leg->ResetBit(kCanDelete);
+    for (TLatex *tex : page.textArray)
+        if (tex)
+            tex->ResetBit(kCanDelete);
+    page.built = true;
+    lastPages.push_front(nPoint);
+
+    // без clear старые примитивы остаются на pad, удалять их нельзя
+    while (clear && lastPages.size() > max_pages)
+    {
+        pages[lastPages.back()].clear();
+        lastPages.pop_back();
+    }
+
+    return &page;
+}
+
+void TSCanvas::drawPad(TMultiGraph *mg, THStack *hs, TLegend *leg, TLatex *tex)
+{
+    if (mg != nullptr)
+        mg->Draw(opt_mg);
+    if (hs != nullptr)
+        hs->Draw(opt_hs);
+    if (leg != nullptr)
+        leg->Draw(opt_leg);
+    if (tex != nullptr)
+        tex->Draw(opt_text);
+}
+
+void TSCanvas::drawPage(int nPoint)
+{
     if (nPoint < (int)titleArray.size())
     {
         this->SetTitle(titleArray[nPoint].c_str());
     }
 
-    last_slider_point  = nPoint;
+    last_slider_point = nPoint;
 
     int N = nx*ny;
-    
+
+    if (clear)
+    {
+        for (int i = 0; i < N; i++)
+        {
+            this->cd(i+1);
+            gPad->Clear();
+        }
+    }
+
+    // вытесненные страницы удаляются после очистки pad
+    TSCanvasPage *page = pages.empty() ? nullptr : getPage(nPoint);
+
     for (int i = 0; i < N; i++)
     {
-        int index = N*nPoint+i;
         this->cd(i+1);
-        if (clear)
-            gPad->Clear();
 
-        if (index < (int)mgArray.size() && mgArray[index] != nullptr)
+        if (page != nullptr)
         {
-            TMultiGraph *mg = mgArray[index];
-            mg->Draw(opt_mg);
+            drawPad(i < (int) page->mgArray.size() ? page->mgArray[i] : nullptr,
+                    i < (int) page->hsArray.size() ? page->hsArray[i] : nullptr,
+                    i < (int) page->legendArray.size() ? page->legendArray[i] : nullptr,
+                    i < (int) page->textArray.size() ? page->textArray[i] : nullptr);
         }
-        if (index < (int)hsArray.size() && hsArray[index] != nullptr)
+        else
         {
-            THStack *hs = hsArray[index];
-            hs->Draw(opt_hs);
-        }
-        if (index < (int) legendArray.size() && legendArray[index] != nullptr) 
-        {
-            TLegend *leg = legendArray[index];
-            leg->Draw(opt_leg);
-        }
-        if (index < (int) textArray.size() && textArray[index] != nullptr) 
-        {
-            TLatex *tex = textArray[index];
-            tex->Draw(opt_text);
+            int index = N*nPoint+i;
+            drawPad(index < (int) mgArray.size() ? mgArray[index] : nullptr,
+                    index < (int) hsArray.size() ? hsArray[index] : nullptr,
+                    index < (int) legendArray.size() ? legendArray[index] : nullptr,
+                    index < (int) textArray.size() ? textArray[index] : nullptr);
         }
         if (grid)
             gPad->SetGrid();
-    }        
+    }
 
     this->Modified();
     this->Update();
 }
-
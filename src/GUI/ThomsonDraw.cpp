@@ -1,9 +1,11 @@
 #include "ThomsonDraw.h"
+#include "GraphPool.h"
 #include "thomsonCounter/Spectrum.h"
 //#include "TSCanvas.h"
 #include <TROOT.h>
 #include <TStyle.h>
 #include <iostream>
+#include <algorithm>
 
 uint &ThomsonDraw::Color(uint &color)
 {
@@ -41,6 +43,7 @@ TCanvas *ThomsonDraw::createCanvas(const char *canvas_name, const char *title, u
 	if( o && o->InheritsFrom(TCanvas::Class()) )
 	{
 		c = (TCanvas*)o;
+		GraphPool::release(c); // графики старых mg будут использованы снова
 		c->Clear();
 		c->GetListOfPrimitives()->Delete();
 		c->SetTitle(cTitle);
@@ -74,6 +77,38 @@ TCanvas *ThomsonDraw::createCanvas(const char *canvas_name, const char *title, u
 	return c;
 }
 
+TCanvas *ThomsonDraw::updateCanvas(const char *canvas_name, const char *title, uint width, uint height, uint divideX, uint divideY)
+{
+    TObject* const o = gROOT->FindObject(canvas_name);
+    if (o && o->InheritsFrom(TCanvas::Class()))
+    {
+        TCanvas *c = (TCanvas*)o;
+        uint nPads = 0;
+        TIter next(c->GetListOfPrimitives());
+        while (TObject *obj = next())
+            if (obj->InheritsFrom(TPad::Class()))
+                nPads++;
+
+        if (nPads == (divideX*divideY > 1 ? divideX*divideY : 0))
+        {
+            for (uint i = 0; i < std::max(nPads, 1u); i++)
+            {
+                TVirtualPad *pad = nPads == 0 ? c : c->cd(i+1);
+                GraphPool::release(pad);
+                pad->Clear();
+            }
+            c->SetTitle(title);
+            c->cd();
+            return c;
+        }
+    }
+
+    TCanvas *c = createCanvas(canvas_name, title, width, height);
+    if (divideX*divideY > 1)
+        c->Divide(divideX, divideY);
+    return c;
+}
+
 TSCanvas *ThomsonDraw::createSCanvas(const char *canvas_name, const char *title, uint nSlider, uint start_point, uint width, uint height, uint divideX, uint divideY)
 {
 	TSCanvas* c;
@@ -84,6 +119,7 @@ TSCanvas *ThomsonDraw::createSCanvas(const char *canvas_name, const char *title,
 	if( o && o->InheritsFrom(TCanvas::Class()) )
 	{
 		c = (TSCanvas*)o;
+        GraphPool::release(c);
         c->getSlider()->SetObject(nullptr);
         c->Clear();
         c->Divide(divideX, divideY);
@@ -247,7 +283,36 @@ void ThomsonDraw::convolution_draw(TCanvas *c, TMultiGraph *mg, const darray &SC
 
 TGraph *ThomsonDraw::createGraph(uint points, const double *const x, const double *const y, const uint color, const uint lineStyle, const uint lineWidth, const char *title, const double * const errorX, const double * const errorY)
 {
-    TGraph *g = new TGraphErrors(points, x, y, errorX, errorY);
+    DecimatedGraph *g = GraphPool::getGraph(points);
+    std::copy(x, x+points, g->GetX());
+    std::copy(y, y+points, g->GetY());
+    if (errorX != nullptr)
+        std::copy(errorX, errorX+points, g->GetEX());
+    else
+        std::fill(g->GetEX(), g->GetEX()+points, 0.);
+    if (errorY != nullptr)
+        std::copy(errorY, errorY+points, g->GetEY());
+    else
+        std::fill(g->GetEY(), g->GetEY()+points, 0.);
+
+    g->SetTitle(title);
+    g->SetBit(kCanDelete);
+    g->SetEditable(kFALSE);
+    g->SetLineWidth(lineWidth);
+    g->SetLineStyle(lineStyle);
+    g->SetLineColor(color);
+    return g;
+}
+
+TGraph *ThomsonDraw::createWaveformGraph(uint points, const sample_t *const x, const sample_t *const y, const uint color, const uint lineStyle, const uint lineWidth, const char *title)
+{
+    DecimatedGraph *g = GraphPool::getGraph(points);
+    std::copy(x, x+points, g->GetX()); // отсчеты sample_t переводятся в double графика
+    std::copy(y, y+points, g->GetY());
+    std::fill(g->GetEX(), g->GetEX()+points, 0.);
+    std::fill(g->GetEY(), g->GetEY()+points, 0.);
+    g->setDecimation(true);
+
     g->SetTitle(title);
     g->SetBit(kCanDelete);
     g->SetEditable(kFALSE);
@@ -259,7 +324,8 @@ TGraph *ThomsonDraw::createGraph(uint points, const double *const x, const doubl
 
 TH1 *ThomsonDraw::createHist(uint points, double xmin, double xmax, const double *const y, const uint color, const uint lineStyle, const uint lineWidth, const char *title, const double *const error)
 {
-    TH1 *h = new TH1D("", "", points, xmin, xmax);
+    TH1 *h = GraphPool::getHist(points, xmin, xmax);
+    h->SetTitle("");
     for (uint i = 0; i < points; i++)
     {
         h->SetBinContent(i+1, y[i]);
@@ -317,7 +383,8 @@ TGraph *ThomsonDraw::createSignalBox(double t1, double t2, double U, uint color,
 
 TH1 *ThomsonDraw::createHistStatistics(const darray &signal, double min, double max, uint nbins, const uint color, const uint lineStyle, const uint lineWidth, const char *title)
 {
-    TH1 *h = new TH1D("", title, nbins, min, max);
+    TH1 *h = GraphPool::getHist(nbins, min, max);
+    h->SetTitle(title);
     h->SetLineColor(color);
     h->SetLineWidth(lineWidth);
     h->SetLineStyle(lineStyle);
@@ -335,9 +402,9 @@ void ThomsonDraw::thomson_draw(TMultiGraph *mg, const SignalProcessing &sp, uint
     //uint color = 1;
 
     uint N_SIGNAL = sp.getTSize();
-    const darray &t = sp.getT();
-    const darray &U = sp.getUShift();
-    const darray &UT = sp.getUTintegrateSignal();
+    const sarray t = sp.getTimeAxis().toArray(); // при равномерной сетке отсчеты времени не хранятся
+    const sarray &U = sp.getUShift();
+    const sarray &UT = sp.getUTintegrateSignal();
     const darray &signal_box = sp.getSignalBox();
 
     uint p0 = 0;
@@ -352,7 +419,7 @@ void ThomsonDraw::thomson_draw(TMultiGraph *mg, const SignalProcessing &sp, uint
 
     for (uint p = p0; p < p1; p++) 
     {
-        if (p < work_mask.size() && !work_mask[p])
+        if ((p < work_mask.size() && !work_mask[p]) || N_SIGNAL == 0) // N_SIGNAL == 0 - сигналы без осциллограмм (из кэша)
         {
             Color(color); //каждый канал определеного цвета
             continue;
@@ -369,16 +436,20 @@ void ThomsonDraw::thomson_draw(TMultiGraph *mg, const SignalProcessing &sp, uint
         }
 
         if (!integrate) {
-            TGraph *g = createGraph(N_SIGNAL, t.data()+p*N_SIGNAL, U.data()+p*N_SIGNAL, color, 1, 2, title);
+            TGraph *g = createWaveformGraph(N_SIGNAL, t.data()+p*N_SIGNAL, U.data()+p*N_SIGNAL, color, 1, 2, title);
 
-            for (uint i = 0; i < N_SIGNAL; i++)
-                g->SetPointY(i, scale*g->GetPointY(i));
+            if (scale != 1.)
+            {
+                double *y = g->GetY();
+                for (uint i = 0; i < N_SIGNAL; i++)
+                    y[i] *= scale;
+            }
 
             mg->Add(g, "L");
         }
         else if (integrate > 0) {
 
-            mg->Add(createGraph(N_SIGNAL, t.data()+p*N_SIGNAL, UT.data()+p*N_SIGNAL, color, 1, 2, title), "L");
+            mg->Add(createWaveformGraph(N_SIGNAL, t.data()+p*N_SIGNAL, UT.data()+p*N_SIGNAL, color, 1, 2, title), "L");
 
             if (sp.getWorkSignals()[p] || channel >= 0)
             {
@@ -409,8 +480,8 @@ void ThomsonDraw::thomson_draw(TMultiGraph *mg, const SignalProcessing &sp, uint
             }
         }
         else {
-            mg->Add(createGraph(N_SIGNAL, t.data()+p*N_SIGNAL, U.data()+p*N_SIGNAL, color, 1, 2, title), "L");
-            mg->Add(createGraph(N_SIGNAL, t.data()+p*N_SIGNAL, UT.data()+p*N_SIGNAL, color), "L");
+            mg->Add(createWaveformGraph(N_SIGNAL, t.data()+p*N_SIGNAL, U.data()+p*N_SIGNAL, color, 1, 2, title), "L");
+            mg->Add(createWaveformGraph(N_SIGNAL, t.data()+p*N_SIGNAL, UT.data()+p*N_SIGNAL, color), "L");
         }
 
         Color(color);
@@ -1,4 +1,5 @@
 #include "ThomsonGUI.h"
+#include "ResultTree.h"
 #include <iostream>
 #include <fstream>
 #include <random>
@@ -37,127 +38,9 @@ ClassImp(ThomsonGUI)
 
 #define ENERGY_COEFF 0.287
 
-void ThomsonGUI::readDataFromArchive(const char *archive_name, const char *kust, const char *signal_name, int shot, darray &t, darray &U, int timePoint, int timeList, const uint N_INFORM, const uint N_UNUSEFULL) const
-{
-    const uint N_POINT = N_INFORM+N_UNUSEFULL;
-    OpenArchive(archive_name);
-
-    shot = getShot(shot);
-
-    const uint tSize = N_INFORM / 2;
-
-    TSignal *signal = GetSignal(signal_name, kust, shot);
-
-    if (signal != nullptr)
-    {
-        if (timeList <= 0)
-            timeList = signal->GetSize() / (N_POINT);
-
-        if (timePoint < 0)
-        {
-            t.reserve(t.size()+tSize*N_TIME_LIST);
-            U.reserve(U.size()+tSize*N_TIME_LIST);
-        }
-        else
-        {
-            t.reserve(t.size()+tSize);
-            U.reserve(U.size()+tSize);
-        }
-
-        uint step = timePoint < 0. ? 0. : timePoint*N_POINT;
-        
-        for (int it = std::max(0, timePoint); it < timeList; it++)
-        {
-            if (step >= signal->GetSize() || (it == timePoint+1 && timePoint >= 0))
-                break;
-
-            for (uint i = 0; i < tSize; i++)
-            {
-                if (timePoint < 0 || it == timePoint)
-                {
-                    t.push_back((*signal)[step]);
-                    U.push_back((*signal)[step+1]);
-                }
-
-                step += 2;
-            }
-
-            step += N_UNUSEFULL;
-        }
-    }
-    else
-    {
-        std::cout << "заполняем нулями\n";
-        timeList = N_TIME_LIST;
-        for (int it = std::max(0, timePoint); it < timeList; it++)
-        {
-            if ((it == timePoint+1 && timePoint >= 0))
-                break;
-
-            for (uint i = 0; i < tSize; i++)
-            {
-                if (timePoint < 0 || it == timePoint)
-                {
-                    t.push_back(0);
-                    U.push_back(0);
-                }
-            }
-        }
-    }
-
-    if (signal != nullptr)
-        delete signal;
-    CloseArchive();
-}
-
-darray ThomsonGUI::readCalibration(const char *archive_name, const char *calibration_name, int shot) const
-{
-    darray calibration;
-
-    if (TFile *file=OpenArchive(archive_name)) 
-    {
-
-        getShot(shot);
-
-        TString shot_string = TString::Format("%d", shot);
-        TString shot_name = file->GetDirectory(shot_string) != nullptr ? GetShotCalibration(shot) : shot_string;
-
-        TSignalC *calibration_signal = nullptr;
-        calibration_signal = (TSignalC*) GetCalibration(calibration_name, shot_name);
-
-        if (calibration_signal != nullptr) 
-        {
-            uint size = calibration_signal->GetSize()/sizeof(double);
-
-            calibration.reserve(size);
-
-            double *cal = reinterpret_cast<double*> (calibration_signal->GetArray());
-
-            for (uint i  = 0; i < size; i++)
-                calibration.push_back(cal[i]);
-        }
-
-        delete calibration_signal; 
-
-    }
-
-    CloseArchive();
-
-    // for (uint sp = 0; sp < N_SPECTROMETERS; sp++)
-    // {
-    //     for (uint cal = 0; cal < N_SPECTROMETER_CALIBRATIONS; cal++)
-    //     {
-    //         uint index = sp*N_SPECTROMETER_CALIBRATIONS + cal;
-    //         std::cout << calibration[index] << " ";
-    //     }
-    //     std::cout << "\n";
-    // }
-
-    // for (uint i = 0; i < calibration.size(); i++)
-    //     std::cout << calibration[i] << "\n";
-
-    return calibration;
-}
+#define RESULT_CACHE_FOLDER "cache/"
+#define RESULT_TREE_FILE "result_tree.root"
+#define SNAPSHOT_FOLDER "" // снимки выстрелов вместо архива (например "snapshots/"), пустое - только архив
 
 bool ThomsonGUI::isCalibrationNew(TFile *f, const char *calibration_name) const
 {
@@ -211,121 +94,6 @@ bool ThomsonGUI::writeCalibration(const char *archive_name, const char *calibrat
     return true;
 }
 
-void ThomsonGUI::processingSignalsData(const char *archive_name, int shot, const std::vector<parray> &parametersArray, bool clearArray)
-{
-    if (clearArray)
-        this->clearSpArray();
-
-    spArray.reserve(spArray.size()+N_SPECTROMETERS*N_TIME_LIST);
-
-    for (uint sp = 0; sp < N_SPECTROMETERS; sp++)
-    {
-        for (uint it = 0; it < N_TIME_LIST; it++)
-        {
-            darray t;
-            darray U;
-            t.reserve(N_TIME_SIZE*N_CHANNELS);
-            U.reserve(N_TIME_SIZE*N_CHANNELS);
-
-            for (uint ch = 0; ch < N_CHANNELS; ch++)
-            {
-                TString signal_name = getSignalName(sp, ch);
-                uint T_SIZE_OLD = t.size();
-                readDataFromArchive(archive_name, KUST_NAME, signal_name, shot, t, U, it, 0, N_TIME_SIZE*2, UNUSEFULL);
-                if (T_SIZE_OLD == t.size())
-                {
-                    std::cout << "shot " << shot << " sp " << sp << " tp " << it << " заполнена нулями\n";
-                    for (uint i = 0; i < N_TIME_SIZE; i++)
-                    {
-                        t.push_back(0.);
-                        U.push_back(0.);
-                    }
-                }
-            }
-            spArray.push_back(new SignalProcessing(t, U, N_CHANNELS, parametersArray[sp], sigmaCoeff, work_mask[sp]));
-        }
-    }
-}
-
-bool ThomsonGUI::countThomson(const std::string &archive_name, const std::string &srf_file_folder, const std::string &convolution_file_folder, int shot, bool clearArray, int selectionMethod, uint shot_index, bool count)
-{
-    //bool thomsonSuccess = true;
-    if (clearArray) clearCounterArray();
-    counterArray.reserve(counterArray.size()+N_SPECTROMETERS*N_TIME_LIST);
-
-    darray calibrations = getCalibration(archive_name.c_str(), shot, true, useCalibrations->IsDown());
-    double coeff_to_energy = calibrations[N_SPECTROMETER_CALIBRATIONS*N_SPECTROMETERS-1+ID_N_ADD_ENERGY];
-    for (uint it = 0; it < N_TIME_LIST; it++)
-    {
-        getSignalProcessing(it, NUMBER_ENERGY_SPECTROMETER, shot_index)->setCoeffToEnergy(coeff_to_energy);
-    }
-    /*darray calibrations = readCalibration(archive_name.c_str(), CALIBRATION_NAME, shot);
-
-    if (calibrations.size() == 0)
-    {
-        OpenArchive(archive_name.c_str());
-        int lastShotCal = GetLastShot()+1;
-        CloseArchive();
-        calibrations = readCalibration(archive_name.c_str(), CALIBRATION_NAME, lastShotCal);
-
-        if (calibrations.size() == 0)
-            calibrations = readCalibration(archive_name.c_str(), CALIBRATION_NAME, lastShotCal-1);
-    }
-
-    if (calibrations.size() < N_SPECTROMETERS*N_SPECTROMETER_CALIBRATIONS)
-        calibrations.resize(N_SPECTROMETERS*N_SPECTROMETER_CALIBRATIONS, 0);
-
-    //darray ne_coeff = {0.0813323, 0.0742564, 0.0688669, 0.0652062, 0.0577925, 0.0681893};
-    darray ne_coeff = {0.065474, 0.0664481, 0.062434, 0.0649258, 0.0637577, 0.0753984};
-
-    if (shot <= 59000)
-    for (uint i = 0; i < N_SPECTROMETERS; i++)
-        calibrations[i*N_SPECTROMETER_CALIBRATIONS+ID_N_COEFF_CHANNEL_0] = ne_coeff[i]; //поменяли энегрию лазера*/
-
-    std::vector <ThomsonCounter*> tempCounter(N_TIME_LIST*N_SPECTROMETERS, nullptr);
-
-    darray time_points = createTimePointsArray(archive_name, shot);
-
-    for (uint sp = 0; sp < N_SPECTROMETERS; sp++)
-    {
-        std::string srf_file_name = srf_file_folder+"SRF_Spectro-" + std::to_string(sp+1)+".dat";
-        std::string convolution_file_name = convolution_file_folder+"Convolution_Spectro-" + std::to_string(sp+1)+".dat";
-
-        darray Ki(N_CHANNELS, calibrations[sp*N_SPECTROMETER_CALIBRATIONS+ID_N_COEFF_CHANNEL_1]);
-        double x_positon = -calibrations[sp*N_SPECTROMETER_CALIBRATIONS+ID_X]/10.;
-        for (uint it = 0; it < N_TIME_LIST; it++)
-        {
-            double energy = getSignalProcessing(it, NUMBER_ENERGY_SPECTROMETER, shot_index)->getSignals()[NUMBER_ENERGY_CHANNEL];
-            ThomsonCounter * counter = new ThomsonCounter(N_CHANNELS, srf_file_name, convolution_file_name, *getSignalProcessing(it, sp, shot_index), calibrations[sp*N_SPECTROMETER_CALIBRATIONS+ID_THETA], Ki,
-            darray(N_CHANNELS, 0), energy, 0, time_points[it], x_positon, LAMBDA_REFERENCE, selectionMethod);
-            // if (!counter->isWork()) {
-            //     thomsonSuccess = false;
-            //     break;
-            // }
-
-            if (count)
-            {
-                counter->count();
-                counter->countConcentration();
-                counter->countSignalResult();
-            }
-            
-            tempCounter[sp*N_TIME_LIST+it] = counter;
-        }
-
-        // if (!thomsonSuccess)
-        //     break;
-    }
-
-    for (ThomsonCounter *counter : tempCounter)
-    {
-        if (counter != nullptr)
-            counterArray.push_back(counter);
-    }
-
-    return true;
-}
-
 SignalProcessing *ThomsonGUI::getSignalProcessing(uint it, uint sp, uint nShot) const
 {
     if (it >= N_TIME_LIST || sp >= N_SPECTROMETERS || nShot >= N_SHOTS)
@@ -342,164 +110,167 @@ ThomsonCounter *ThomsonGUI::getThomsonCounter(uint it, uint sp, uint nShot) cons
         return counterArray[it+sp*N_TIME_LIST+nShot*N_TIME_LIST*N_SPECTROMETERS];
 }
 
-void ThomsonGUI::clearSpArray()
+void ThomsonGUI::clearShots(bool keepSignals)
 {
-    for (SignalProcessing* it : spArray)
-        delete it;
+    if (!keepSignals) // объекты выстрела остаются в ShotItem, страницы canvas сигналов строятся дальше
+    {
+        shotsVersion++;
+        signalsVersion++;
+    }
+    resultsVersion++;
+    for (ShotArena *arena : arenas)
+        delete arena;
 
+    arenas.clear();
     spArray.clear();
     spArray.shrink_to_fit();
+    counterArray.clear();
+    counterArray.shrink_to_fit();
 }
 
-void ThomsonGUI::clearCounterArray()
+void ThomsonGUI::setTables(uint64_t key)
 {
-    for (ThomsonCounter* it : counterArray)
-        delete it;
-
-    counterArray.clear();
-    counterArray.shrink_to_fit();
+    if (key != tablesKey)
+    {
+        tablesKey = key;
+        tablesVersion++;
+    }
 }
 
-darray ThomsonGUI::getCalibration(const char *archive_name, int shot, bool extra, bool set)
+std::string ThomsonGUI::drawView(uint nShot, const std::vector<TGCheckButton *> &buttonArray) const
 {
+    std::string view = std::to_string(nShot) + ":";
+    for (const TGCheckButton *button : buttonArray)
+        view += button->IsDown() ? '1' : '0';
+    return view;
+}
 
-    darray calibration;
-    if (set)
-    {
-        calibration.resize(N_SPECTROMETER_CALIBRATIONS*N_SPECTROMETERS+N_ADD_CALIBRATIONS, 0.);
+bool ThomsonGUI::isCanvasActual(const char *canvas_name, uint data, const std::string &view)
+{
+    DrawState state = {data & DRAW_TABLES ? tablesVersion : 0, data & DRAW_SIGNALS ? signalsVersion : 0, data & DRAW_RESULTS ? resultsVersion : 0, view};
 
-        for (uint i = 0; i < N_SPECTROMETERS; i++)
-        {
-            calibration[i*N_SPECTROMETER_CALIBRATIONS+ID_X] = xPositionCalibration[i]->GetNumber();
-            calibration[i*N_SPECTROMETER_CALIBRATIONS+ID_THETA] = thetaCalibration[i]->GetNumber()/180.*M_PI;
-            calibration[i*N_SPECTROMETER_CALIBRATIONS+ID_N_COEFF_CHANNEL_0] = nCalibrationCoeff0[i]->GetNumber();
-            calibration[i*N_SPECTROMETER_CALIBRATIONS+ID_N_COEFF_CHANNEL_1] = nCalibrationCoeff1[i]->GetNumber();
-        }
+    auto it = drawStates.find(canvas_name);
+    bool actual = it != drawStates.end() && it->second == state && gROOT->GetListOfCanvases()->FindObject(canvas_name) != nullptr; // canvas мог быть закрыт
+    drawStates[canvas_name] = state;
+    return actual;
+}
 
-        calibration[N_SPECTROMETERS*N_SPECTROMETER_CALIBRATIONS-1+ID_N_ADD_ENERGY] = energyCalibration->GetNumber();
-        return calibration;
-    }
+void ThomsonGUI::setSCanvasPages(TSCanvas *c, const std::function<void(uint it, uint sp, TSCanvasPage &page)> &addSpectrometer)
+{
+    uiarray spectrometers;
+    for (uint i = 0; i < N_SPECTROMETERS; i++)
+        if (checkButtonDrawSpectrometers[i]->IsDown())
+            spectrometers.push_back(i);
 
+    uint version = shotsVersion;
+    c->setPageBuilder([this, spectrometers, version, addSpectrometer](int it, TSCanvasPage &page) {
+        if (version != shotsVersion) // объекты выстрела уже удалены
+            return;
+        for (uint sp : spectrometers)
+            addSpectrometer(it, sp, page);
+    });
+    c->drawPage(N_FIRST_WORK_TIME_PAGE);
+}
 
-    if (shot <= 0)
+void ThomsonGUI::addShotResult(ShotItem &item, bool keep)
+{
+    if (keep)
     {
-        OpenArchive(archive_name);
-        shot = getShot(shot);
-        CloseArchive();
+        spArray.insert(spArray.end(), item.spArray.begin(), item.spArray.end());
+        counterArray.insert(counterArray.end(), item.counterArray.begin(), item.counterArray.end());
+        arenas.push_back(item.arena.release());
+        item.spArray.clear();
+        item.counterArray.clear();
     }
-
-    if (shot < 57845) // новый формат
-    {
-        calibration = {
-            0., 96.704*M_PI/180., 0.0813323, 0.0813323,
-            -32., 99.474*M_PI/180., 0.0742564, 0.0742564,
-            -63.5, 102.158*M_PI/180., 0.0688669, 0.0688669,
-            -95.5, 104.831*M_PI/180., 0.0652062, 0.0652062,
-            -127.5, 107.439*M_PI/180., 0.0577925, 0.0577925,
-            -156, 109.687*M_PI/180., 0.0681893, 0.0681893,
-            0.287
-        };
-
-    }
-    else if (shot <= 57986) // перешли на новые калибровки
-    {
-        calibration = {
-            0., 96.704*M_PI/180., 0.065474, 0.065474,
-            -32., 99.474*M_PI/180., 0.0664481, 0.0664481,
-            -63.5, 102.158*M_PI/180., 0.062434, 0.062434,
-            -95.5, 104.831*M_PI/180., 0.0649258, 0.0649258,
-            -127.5, 107.439*M_PI/180., 0.0637577, 0.0637577,
-            -156, 109.687*M_PI/180., 0.0753984, 0.0753984,
-            0.287
-        };
-    }
-    else 
+    else // arena вернется в pipeline, выстрел пересчитывается при выборе в loadShotFromSet
     {
-        calibration = readCalibration(archive_name, CALIBRATION_NAME, shot);
-
-        if (calibration.empty() && extra)
-        {
-            OpenArchive(archive_name);
-            int lastShotCal = GetLastShot()+1;
-            CloseArchive();
-            calibration = readCalibration(archive_name, CALIBRATION_NAME, lastShotCal);
-
-            if (calibration.empty())
-                calibration = readCalibration(archive_name, CALIBRATION_NAME, lastShotCal-1);
-        }
+        spArray.insert(spArray.end(), item.spArray.size(), nullptr);
+        counterArray.insert(counterArray.end(), item.counterArray.size(), nullptr);
+        arenas.push_back(nullptr);
     }
-
-
-    if (calibration.size() < N_SPECTROMETER_CALIBRATIONS*N_SPECTROMETERS+N_ADD_CALIBRATIONS)
-        calibration.resize(N_SPECTROMETERS*N_SPECTROMETER_CALIBRATIONS+N_ADD_CALIBRATIONS, 0);
-
-    return calibration;
 }
 
-void ThomsonGUI::meanThomsonData(uint N_SHOTS, darray &Te, darray &TeError, darray &ne, darray &neError, darray &xPositon, darray &time_points) const
+bool ThomsonGUI::loadShotFromSet(uint nShot)
 {
+    const uint N_PAGES = N_TIME_LIST*N_SPECTROMETERS;
 
-    for (uint sp = 0; sp < N_SPECTROMETERS; sp++)
-    {
-        xPositon[sp] = 0.;
-        for (uint ishot = 0; ishot < N_SHOTS; ishot++)
-        {
-            ThomsonCounter *counter = getThomsonCounter(0, sp, ishot);
-            xPositon[sp] += counter->getXPositon()/N_SHOTS;
-        }
-    } //усредняем позицию
+    if (countType != CountType::SetOfShots || nShot >= N_SHOTS || (nShot+1)*N_PAGES > spArray.size())
+        return false;
 
-    for (uint it = 0; it < N_TIME_LIST; it++)
+    if (spArray[nShot*N_PAGES] != nullptr)
+        return true;
+
+    if (loadedShot != 0) // хранится не больше одного пересчитанного выстрела
     {
-        time_points[it] = 0.;
-        for (uint ishot = 0; ishot < N_SHOTS; ishot++)
+        shotsVersion++;
+        delete arenas[loadedShot];
+        arenas[loadedShot] = nullptr;
+        for (uint i = loadedShot*N_PAGES; i < (loadedShot+1)*N_PAGES; i++)
         {
-            ThomsonCounter *counter = getThomsonCounter(it, NUMBER_ENERGY_SPECTROMETER, ishot);
-            time_points[it] += counter->getTimePoint()/N_SHOTS;
+            spArray[i] = nullptr;
+            counterArray[i] = nullptr;
         }
-    }//усредняем время
+        loadedShot = 0;
+    }
 
+    changeStatusText(statusEntrySetOfShots, TString::Format("count shot %u", shotArray[nShot]));
 
-    for (uint it = 0; it < N_TIME_LIST; it++)
+    ShotItem item;
+    busy = true;
+    pipeline.countShot(shotSettings, shotArray[nShot], item);
+    busy = false;
+    signalsVersion++;
+    resultsVersion++;
+    for (uint i = 0; i < N_PAGES; i++)
     {
-        for (uint sp = 0; sp < N_SPECTROMETERS; sp++)
-        {
-            uint index = sp+it*N_SPECTROMETERS;
-            Te[index] = 0.;
-            ne[index] = 0.;
-
-            double wT=0.;
-            double wN=0.;
+        spArray[nShot*N_PAGES+i] = item.spArray[i];
+        counterArray[nShot*N_PAGES+i] = item.counterArray[i];
+    }
+    arenas[nShot] = item.arena.release();
+    item.spArray.clear();
+    item.counterArray.clear();
+    loadedShot = nShot;
 
-            for (uint ishot = 0; ishot < N_SHOTS; ishot++)
-            {
-                ThomsonCounter *counter = getThomsonCounter(it, sp, ishot);
+    statusEntrySetOfShots->SetText("ready");
+    return true;
+}
 
-                double w1 = 1./(counter->getTError()*counter->getTError());
-                double w2 = 1./(counter->getNError()*counter->getNError());
+barray ThomsonGUI::timeMaskSetOfShots() const
+{
+    barray time_mask(N_TIME_LIST, false);
+    for (uint it = 0; it < N_TIME_LIST; it++)
+        time_mask[it] = checkButtonDrawTimeSetOfShots[it]->IsDown();
+    return time_mask;
+}
 
-                wT += w1;
-                wN += w2;
+bool ThomsonGUI::isBusy() const
+{
+    if (busy)
+        std::cerr << "идет обработка выстрелов, дождитесь окончания!\n";
+    return busy;
+}
 
-                Te[index] += counter->getT()*w1;
-                ne[index] += counter->getN()*w2;
-            }
+darray ThomsonGUI::getCalibration(const char *archive_name, int shot, bool extra, bool set)
+{
 
-            Te[index] /= wT;
-            ne[index] /= wN;
-            TeError[index] = 1./sqrt(wT);
-            neError[index] = 1./sqrt(wN);
+    darray calibration;
+    if (set)
+    {
+        calibration.resize(N_SPECTROMETER_CALIBRATIONS*N_SPECTROMETERS+N_ADD_CALIBRATIONS, 0.);
 
-            if (std::isnan(Te[index]) || std::isnan(TeError[index]) || std::isnan(ne[index]) || std::isnan(neError[index])) 
-            {
-                Te[index] = 0.;
-                ne[index] = 0.;
-                TeError[index] = 0.;
-                neError[index] = 0.;
-            }
+        for (uint i = 0; i < N_SPECTROMETERS; i++)
+        {
+            calibration[i*N_SPECTROMETER_CALIBRATIONS+ID_X] = xPositionCalibration[i]->GetNumber();
+            calibration[i*N_SPECTROMETER_CALIBRATIONS+ID_THETA] = thetaCalibration[i]->GetNumber()/180.*M_PI;
+            calibration[i*N_SPECTROMETER_CALIBRATIONS+ID_N_COEFF_CHANNEL_0] = nCalibrationCoeff0[i]->GetNumber();
+            calibration[i*N_SPECTROMETER_CALIBRATIONS+ID_N_COEFF_CHANNEL_1] = nCalibrationCoeff1[i]->GetNumber();
         }
+
+        calibration[N_SPECTROMETERS*N_SPECTROMETER_CALIBRATIONS-1+ID_N_ADD_ENERGY] = energyCalibration->GetNumber();
+        return calibration;
     }
 
+    return pipeline.getCalibration(archive_name, shot, extra);
 }
 
 bool ThomsonGUI::shotNumberFromSetOfShots(uint &shot_number_from_set_of_shots, uint &shotDiagnostic, int shot)
@@ -527,45 +298,6 @@ bool ThomsonGUI::shotNumberFromSetOfShots(uint &shot_number_from_set_of_shots, u
     return true;
 }
 
-bool ThomsonGUI::getline(std::ifstream &fin, std::string &line, char comment) const
-{
-    while (std::getline(fin, line))
-    {
-        if (line.size() != 0 && line[0] != comment)    
-            return true;
-    }
-    
-    return false;
-}
-
-void ThomsonGUI::readError(const char *file_name, std::vector<std::pair<double, double>> &sigmaCoeff)
-{
-
-    sigmaCoeff.clear();
-    sigmaCoeff.resize(N_CHANNELS*N_SPECTROMETERS, std::pair<double, double> (0, 0));
-
-
-    std::ifstream fin;
-    fin.open(file_name);
-
-    if (fin.is_open())
-    {
-        for (uint i = 0; i < N_CHANNELS*N_SPECTROMETERS; i++)
-            fin >> sigmaCoeff[i].first;
-
-        for (uint i = 0; i < N_CHANNELS*N_SPECTROMETERS; i++)
-            fin >> sigmaCoeff[i].second;
-
-    }   
-    else
-    {
-        std::cerr << "не удалось прочитать файл error\n";
-    }
-
-    fin.close();
-
-}
-
 void ThomsonGUI::readRamanCrossSection(const char *raman_file_name)
 {
     raman_parameters.clear();
@@ -644,62 +376,6 @@ void ThomsonGUI::changeStatusText(TGTextEntry *entry, const char *text)
     gSystem->ProcessEvents();
 }
 
-barray ThomsonGUI::createWorkMask(const std::string &work_mask_string) const
-{
-    barray work_mask(N_CHANNELS, false);
-
-    for (uint i = 0; i < std::min((uint) work_mask_string.size(), N_WORK_CHANNELS); i++)
-        work_mask[i] = work_mask_string[i] == '+' ? true : false;
-
-    return work_mask;
-}
-
-TString ThomsonGUI::getSignalName(uint nSpectrometer, uint nChannel) const
-{
-    return TString::Format("ts%u-f-ch%u", nSpectrometer+1, nChannel+1);
-}
-
-int &ThomsonGUI::getShot(int &shot) const
-{
-    if (shot <= 0)
-        shot += GetLastShot();
-    return shot;
-}
-
-std::vector<parray> ThomsonGUI::readParametersToSignalProcessing(const std::string &file_name) const
-{
-    std::vector <parray> parametersArray(N_SPECTROMETERS, parray(N_CHANNELS));
-
-    std::ifstream fin;
-    fin.open(file_name);
-    if (fin.is_open())
-    {
-        std::string line;
-        for (uint sp = 0; sp < N_SPECTROMETERS; sp++)
-        {
-            fin >> line;
-            for (uint ch = 0; ch < N_CHANNELS; ch++)
-            {
-
-                SignalProcessingParameters pr;
-
-                fin >> line >> pr.start_point_from_start_zero_line >> pr.step_from_start_zero_line >>
-                pr.start_point_from_end_zero_line >> pr.step_from_end_zero_line
-                >> pr.signal_point_start >> pr.signal_point_step >> pr.point_integrate_start >>
-                pr.threshold >> pr.increase_point >> pr.decrease_point >> pr.klim;
-
-                parametersArray[sp][ch] = pr;
-            }
-        }
-    }
-    else {
-        std::cerr << "не удалось открыть файл с параметрами: " << file_name  << "!\n";
-    }
-    fin.close();
-
-    return parametersArray;
-}
-
 void ThomsonGUI::writeResultTableToFile(const char *file_name) const
 {
     if (countType == CountType::None)
@@ -781,7 +457,7 @@ void ThomsonGUI::writeResultTableToFile(const char *file_name) const
     fout.close();
 }
 
-void ThomsonGUI::diactiveDiagnosticFrame(const char *text)
+void ThomsonGUI::diactiveDiagnosticFrame(const char *text, bool keepSignals)
 {
     changeStatusText(statusEntry, text);
     changeStatusText(statusEntrySetOfShots, STATUS_ENTRY_TEXT);
@@ -794,8 +470,9 @@ void ThomsonGUI::diactiveDiagnosticFrame(const char *text)
     setDrawEnable(0, 0, 0, 0);
     shotDiagnostic = 0;
     shotArray.clear();
-    clearCounterArray();
-    clearSpArray();
+    clearShots(keepSignals);
+    statistics.clear();
+    loadedShot = 0;
 }
 
 uiarray ThomsonGUI::createArrayShots(const std::string &archive_name)
@@ -849,62 +526,6 @@ uiarray ThomsonGUI::createArrayShots(const std::string &archive_name)
     return shotArray;
 }
 
-darray ThomsonGUI::createTimePointsArray(const std::string &archive_name, int shot) const
-{
-    darray time_points(N_TIME_LIST, 0.);
-    TFile *file = OpenArchive(archive_name.c_str());
-
-    if (file != nullptr)
-    {
-        TDirectory *dir = file->GetDirectory(TString::Format("%d/MSE", shot));
-
-        if (dir != nullptr)
-        {
-            TSignal* signal = (TSignal*) dir->FindObjectAny("ts_ref2");
-            if (signal != nullptr)
-            {
-                uint size = signal->GetSize();
-                double t0 = signal->GetXShift();
-                double dt = signal->GetXQuant();
-                double level = 0.2;
-                bool isSignal = false;
-                uint it = 1;
-                for (uint i = 0; i < size; i++)
-                {
-                    double t = t0 + i * dt;
-                    double sig = (*signal)[i];
-                    
-                    if (sig >= level && !isSignal)
-                    {
-                        isSignal = true;
-                        time_points[it] = t*1e-3;
-                        it++;
-                        if (it == N_TIME_LIST)
-                            break;
-                    }
-
-                    if (sig < level && isSignal)
-                    {
-                        isSignal = false;
-                    }
-
-                }
-
-            }
-        }
-
-    }
-    else
-    {
-        for (uint i = 0; i < N_TIME_LIST; i++)
-            time_points[i] = 0;
-    }
-
-    CloseArchive();
-
-    return time_points;
-}
-
 void ThomsonGUI::calibrateRaman(double P, double T, const darray &signalRaman_to_ERaman, const darray &lambda, const darray &SRF, darray &Ki) const
 {
     Ki.resize(N_CHANNELS, 0);
@@ -999,32 +620,6 @@ void ThomsonGUI::calibrateRaman(double P, double T, const darray &signalRaman_to
     std::cout << "########################################################################\n";
 }
 
-bool ThomsonGUI::readFileInput( std::ifstream &fin,
-    std::string &srf_file_folder, std::string &convolution_file_folder, 
-    std::string &raman_file_name, std::string &archive_file_name, std::string &error_file_name,
-    std::string *work_mask_string, std::string &processing_parameters, int &type) const
-{
-    getline(fin, srf_file_folder);
-    getline(fin, convolution_file_folder);
-    getline(fin, raman_file_name);
-    getline(fin, archive_file_name);
-    getline(fin, error_file_name);
-
-    if (work_mask_string != nullptr)
-        for (uint i = 0; i < N_SPECTROMETERS; i++)
-            getline(fin, work_mask_string[i]);
-    else
-    {
-        std::string temp;
-        for (uint i = 0; i < N_SPECTROMETERS; i++)
-            getline(fin, temp);
-    }
-
-    getline(fin, processing_parameters);
-    fin >> type;
-    return fin.fail();
-}
-
 uint ThomsonGUI::getNumberActiveCheck(const std::vector<TGCheckButton *> &buttonArray) const
 {
     uint count = 0;
@@ -1049,8 +644,11 @@ ThomsonGUI::ThomsonGUI(const TGWindow *p, UInt_t width, UInt_t height, TApplicat
     NUMBER_ENERGY_SPECTROMETER(NUMBER_ENERGY_SPECTROMETER), NUMBER_ENERGY_CHANNEL(NUMBER_ENERGY_CHANNEL),
     N_SPECTROMETER_CALIBRATIONS(N_SPECTROMETER_CALIBRATIONS), N_WORK_CHANNELS(N_WORK_CHANNELS),
     N_FIRST_WORK_TIME_PAGE(N_FIRST_WORK_TIME_PAGE),
-    app(app), N_SHOTS(1),countType(CountType::None), 
-    work_mask(N_SPECTROMETERS, barray(N_CHANNELS)), timer(nullptr)
+    pipeline(KUST_NAME, CALIBRATION_NAME, LAMBDA_REFERENCE, N_TIME_SIZE, UNUSEFULL, N_TIME_LIST, N_SPECTROMETERS, N_CHANNELS,
+            NUMBER_ENERGY_SPECTROMETER, NUMBER_ENERGY_CHANNEL, N_SPECTROMETER_CALIBRATIONS, N_WORK_CHANNELS),
+    busy(false), app(app), N_SHOTS(1),countType(CountType::None), 
+    work_mask(N_SPECTROMETERS, barray(N_CHANNELS)),
+    statistics(N_TIME_LIST, N_SPECTROMETERS, N_CHANNELS, NUMBER_ENERGY_SPECTROMETER, NUMBER_ENERGY_CHANNEL), loadedShot(0), shotsVersion(0), tablesKey(0), signalKey(0), tablesVersion(0), signalsVersion(0), resultsVersion(0), timer(nullptr)
 {
     SetCleanup(kDeepCleanup);
 
@@ -1062,8 +660,15 @@ ThomsonGUI::ThomsonGUI(const TGWindow *p, UInt_t width, UInt_t height, TApplicat
         mainFileTextEntry = new TGTextEntry(hframe);
         openMainFileDialogButton->Connect("Clicked()", CLASS_NAME, this, "OpenMainFileDialog()");
 
+        useResultCache = new TGCheckButton(hframe, "cache");
+        useResultCache->SetToolTipText("use results saved in " RESULT_CACHE_FOLDER);
+        useResponseTables = new TGCheckButton(hframe, "tables");
+        useResponseTables->SetToolTipText("fit with (Te, theta) response tables saved in " RESULT_CACHE_FOLDER);
+
         hframe->AddFrame(openMainFileDialogButton, new TGLayoutHints(kLHintsLeft, 5, 5, 5, 5));
         hframe->AddFrame(mainFileTextEntry, new TGLayoutHints(kLHintsExpandX, 5, 5, 5, 5));
+        hframe->AddFrame(useResultCache, new TGLayoutHints(kLHintsRight, 5, 5, 7, 7));
+        hframe->AddFrame(useResponseTables, new TGLayoutHints(kLHintsRight, 5, 5, 7, 7));
     }
 
     TGTab *fTap = new TGTab(this, width, height);
@@ -1079,7 +684,7 @@ ThomsonGUI::ThomsonGUI(const TGWindow *p, UInt_t width, UInt_t height, TApplicat
 
         TGButton *readMainFileButton = new TGTextButton(hframe, "Count");
         writeResultTable = new TGCheckButton(hframe);
-        writeResultTable->SetToolTipText("write result to last_result_table.dat");
+        writeResultTable->SetToolTipText("write result to last_result_table.dat, set of shots append to " RESULT_TREE_FILE);
 
         readMainFileButton->SetToolTipText("count until draw graphs for diagnostic");
 
@@ -1280,11 +885,15 @@ ThomsonGUI::ThomsonGUI(const TGWindow *p, UInt_t width, UInt_t height, TApplicat
         cheakButtonCountThomsonSeveralShots->SetToolTipText("count Te and ne for shot");
         countButton->SetToolTipText("count until draw graphs for set of shots");
         countButton->Connect("Clicked()", CLASS_NAME, this, "CountSeveralShot()");
+        queueDepthEntry = new TGNumberEntry(hframe_button, 2, 3, -1, TGNumberFormat::kNESInteger,
+                                            TGNumberFormat::kNEAPositive, TGNumberEntry::kNELLimitMin, 1);
+        queueDepthEntry->GetNumberEntry()->SetToolTipText("number of shots buffered between read, processing and fit stages");
         hframe_button->AddFrame(addButton, new TGLayoutHints(kLHintsLeft|kLHintsTop,5,5,5,5));
         hframe_button->AddFrame(removeButton, new TGLayoutHints(kLHintsLeft|kLHintsTop,5,5,5,5));
         hframe_button->AddFrame(removeAllButton, new TGLayoutHints(kLHintsLeft|kLHintsTop,5,5,5,5));
         hframe_button->AddFrame(countButton, new TGLayoutHints(kLHintsRight,5,5,5,5));
         hframe_button->AddFrame(cheakButtonCountThomsonSeveralShots, new TGLayoutHints(kLHintsRight,5,2,7,7));
+        hframe_button->AddFrame(queueDepthEntry, new TGLayoutHints(kLHintsRight,5,5,5,5));
         
         fCanvas = new TGCanvas(fTTu, 260, 100, kSunkenFrame|kDoubleBorder);
         fTTu->AddFrame(fCanvas, new TGLayoutHints(kLHintsTop|kLHintsLeft,5,5,5,5));
@@ -1548,6 +1157,9 @@ ThomsonGUI::ThomsonGUI(const TGWindow *p, UInt_t width, UInt_t height, TApplicat
 
 void ThomsonGUI::ReadMainFile()
 {
+    if (isBusy())
+        return;
+
     TString fileName = mainFileTextEntry->GetText();
     bool thomsonSuccess = false;
 
@@ -1556,8 +1168,16 @@ void ThomsonGUI::ReadMainFile()
 
     if (fin.is_open())
     {
-        diactiveDiagnosticFrame("count start");
-        shotArray.clear();
+        ShotItem previous; // прошлый выстрел, сигналы можно использовать если изменились только калибровки
+        if (countType == CountType::OneShot && arenas.size() == 1 && arenas[0] != nullptr)
+        {
+            previous.shot = shotDiagnostic;
+            previous.arena.reset(arenas[0]);
+            previous.spArray = spArray;
+            previous.counterArray = counterArray;
+            arenas[0] = nullptr;
+        }
+
         std::string archive_name;
         std::string srf_file_folder;
         std::string convolution_file_folder;
@@ -1567,7 +1187,7 @@ void ThomsonGUI::ReadMainFile()
         std::string processing_paramters;
         int type;
 
-        readFileInput(fin, srf_file_folder, convolution_file_folder, 
+        pipeline.readFileInput(fin, srf_file_folder, convolution_file_folder, 
         raman_file_name, archive_name, error_file_name, work_mask_string, processing_paramters, type);
 
         if (!fin.fail())
@@ -1575,25 +1195,63 @@ void ThomsonGUI::ReadMainFile()
             int shot = shotNumber->GetNumber();
 
             OpenArchive(archive_name.c_str());
-            shotDiagnostic = getShot(shot);
+            pipeline.getShot(shot);
             CloseArchive();
 
-            createTimePointsArray(archive_name, shotDiagnostic);
-            readError(error_file_name.c_str(), sigmaCoeff);
+            pipeline.readError(error_file_name.c_str(), sigmaCoeff);
             readRamanCrossSection(raman_file_name.c_str());
-            std::vector <parray> parametersArray = readParametersToSignalProcessing(processing_paramters);
 
             for (uint i = 0; i < N_SPECTROMETERS; i++)
             {
-                barray mask = createWorkMask(work_mask_string[i]);
+                barray mask = pipeline.createWorkMask(work_mask_string[i]);
                 for (uint j = 0; j < N_CHANNELS; j++)
                     work_mask[i][j] = mask[j];
             }
 
-            processingSignalsData(archive_name.c_str(), shotDiagnostic, parametersArray, true);
-            thomsonSuccess = countThomson(archive_name, srf_file_folder, convolution_file_folder, shotDiagnostic, true, type);
-
+            ShotSettings settings;
+            settings.archive_name = archive_name;
+            settings.srf_file_folder = srf_file_folder;
+            settings.convolution_file_folder = convolution_file_folder;
+            settings.cache_folder = RESULT_CACHE_FOLDER;
+            settings.snapshot_folder = SNAPSHOT_FOLDER;
+            settings.responseTables = useResponseTables->IsDown();
+            settings.parametersArray = pipeline.readParametersToSignalProcessing(processing_paramters);
+            settings.sigmaCoeff = sigmaCoeff;
+            settings.work_mask = work_mask;
+            settings.selectionMethod = type;
+            settings.count = true;
+            if (useCalibrations->IsDown())
+                settings.calibrations = getCalibration(archive_name.c_str(), shot, true, true);
+            if (useResultCache->IsDown())
+                settings.configHash = pipeline.configurationHash(srf_file_folder, convolution_file_folder, error_file_name, processing_paramters, work_mask_string, type, true,
+                                                                 settings.responseTables);
+
+            uint64_t tables = pipeline.tablesHash(settings);
+            uint64_t signals = pipeline.signalHash(settings, shot);
+
+            // изменились только калибровки или настройки фита, сигналы выстрела остаются
+            bool refit = previous.arena && previous.shot == shot && signals == signalKey && tables == tablesKey;
+            diactiveDiagnosticFrame("count start", refit);
+            shotDiagnostic = shot;
+
+            ShotItem item;
+            if (refit)
+            {
+                item = std::move(previous);
+                pipeline.refitShot(settings, item);
+            }
+            else
+            {
+                previous.clear();
+                pipeline.countShot(settings, shotDiagnostic, item);
+            }
+            signalKey = signals;
+            setTables(tables);
+            addShotResult(item);
+            thomsonSuccess = true;
         }
+        else
+            diactiveDiagnosticFrame("count start");
     }
     else {
         std::cerr << "не удалось открыть файл: " << fileName << "!\n"; 
@@ -1619,6 +1277,9 @@ void ThomsonGUI::ReadMainFile()
 
 void ThomsonGUI::ReadCalibration()
 {
+    if (isBusy())
+        return;
+
     std::string archive_name = "";
     bool fail = false;
     std::ifstream fin;
@@ -1628,7 +1289,7 @@ void ThomsonGUI::ReadCalibration()
     {
         std::string temp;
         int t;
-        fail = readFileInput(fin, temp, temp, temp, archive_name, temp, nullptr, temp, t);
+        fail = pipeline.readFileInput(fin, temp, temp, temp, archive_name, temp, nullptr, temp, t);
     }
     else
         return;
@@ -1661,6 +1322,9 @@ void ThomsonGUI::ReadCalibration()
 
 void ThomsonGUI::WriteCalibration()
 {
+    if (isBusy())
+        return;
+
     std::string archive_name = "";
     bool fail = true;
     std::ifstream fin;
@@ -1670,7 +1334,7 @@ void ThomsonGUI::WriteCalibration()
     {
         std::string temp;
         int t;
-        fail = readFileInput(fin, temp, temp, temp, archive_name, temp, nullptr, temp, t);
+        fail = pipeline.readFileInput(fin, temp, temp, temp, archive_name, temp, nullptr, temp, t);
     }
     else
         return;
@@ -1691,7 +1355,8 @@ void ThomsonGUI::WriteCalibration()
     }
     calibration[N_SPECTROMETERS*N_SPECTROMETER_CALIBRATIONS-1+ID_N_ADD_ENERGY] = energyCalibration->GetNumber();
 
-    writeCalibration(archive_name.c_str(), CALIBRATION_NAME, calibration);
+    if (writeCalibration(archive_name.c_str(), CALIBRATION_NAME, calibration))
+        pipeline.invalidateCalibrations();
 }
 
 void ThomsonGUI::OpenFileDialogTemplate(TGTextEntry *textEntry)
@@ -1719,6 +1384,9 @@ TString ThomsonGUI::getFileFormat(TString fileName)
 
 void ThomsonGUI::DrawGraphs()
 {
+    if (isBusy())
+        return;
+
     if (countType == CountType::None)
         return;
 
@@ -1749,7 +1417,7 @@ void ThomsonGUI::DrawGraphs()
 
     if (countType == CountType::SetOfShots)
     {
-        bool find = shotNumberFromSetOfShots(shot_from_several_shots, shotDiagnostic, shotNumber->GetNumber());
+        bool find = shotNumberFromSetOfShots(shot_from_several_shots, shotDiagnostic, shotNumber->GetNumber()) && loadShotFromSet(shot_from_several_shots);
         if (!find)
         {
             std::cerr << "Выстрел не найден в списке set of shots!\n";
@@ -1773,8 +1441,10 @@ void ThomsonGUI::DrawGraphs()
     if (operatorMode->IsDown())
     {
         TString canvas_name = "Thomson";
-        TCanvas *c = ThomsonDraw::createCanvas(canvas_name, canvasTitle(canvas_name, shotDiagnostic), 1000, 850);
-        c->Divide(2, 2);
+        if (isCanvasActual(canvas_name, DRAW_RESULTS, drawView(shot_from_several_shots, {})))
+            return;
+
+        TCanvas *c = ThomsonDraw::updateCanvas(canvas_name, canvasTitle(canvas_name, shotDiagnostic), 1000, 850, 2, 2); // окно оператора не пересоздается
 
         {
             double Te_max = 0.;
@@ -1906,10 +1576,13 @@ void ThomsonGUI::DrawGraphs()
         return;
     }
 
+    const std::string spectrometersView = drawView(shot_from_several_shots, checkButtonDrawSpectrometers);
+    const std::string timeView = drawView(shot_from_several_shots, checkButtonDrawTime);
+    const std::string spectrometersTimeView = drawView(shot_from_several_shots, checkButtonDrawSpectrometersFromTime);
 
     if (getNumberActiveCheck(checkButtonDrawSpectrometers) != 0)
     {
-        if (checkButton(drawSRF) && thomsonDraw)
+        if (checkButton(drawSRF) && thomsonDraw && !isCanvasActual("SRF", DRAW_TABLES | DRAW_RESULTS, spectrometersView))
         {
             TString canvas_name = "SRF";
             // TCanvas *c = ThomsonDraw::createCanvas(canvas_name, canvasTitle(canvas_name), width, height, NxUpdate, NyUpdate);
@@ -1933,47 +1606,15 @@ void ThomsonGUI::DrawGraphs()
                 titleArray[i] = canvasTitle(canvas_name, shotDiagnostic, i);
             c->setTitleArray(titleArray);
 
-            std::vector <TMultiGraph*> mgArray;
-            //std::vector <TLegend*> legArray;
-            mgArray.reserve(NxUpdate*NyUpdate*N_TIME_LIST);
-            //legArray.reserve(NxUpdate*NyUpdate*N_TIME_LIST);
-            for (uint it = 0; it < N_TIME_LIST; it++)
-            {
-                uint index = 1;
-                for (uint i = 0; i < N_SPECTROMETERS; i++)
-                {
-                    if (!checkButtonDrawSpectrometers[i]->IsDown())
-                        continue;
-                    c->cd(index);
-                    index++;
-                    ThomsonCounter *counter = getThomsonCounter(it, i, shot_from_several_shots);
-                    TMultiGraph *mg = ThomsonDraw::createMultiGraph(groupName(canvas_name, i), spectrometerName(i));
-                    mg->ResetBit(kCanDelete);
-                    ThomsonDraw::srf_draw(c, mg,counter->getSRF(), N_WORK_CHANNELS, counter->getLMin(), counter->getLMax(),
-                                         counter->getNLambda(), LAMBDA_REFERENCE, {counter->getT()}, {counter->getTheta()}, false, false);
-                    mgArray.push_back(mg);
-                    //legArray.push_back(ThomsonDraw::createLegend(mg, 0.18, 0.6, 0.35, 0.88, false));
-                    //legArray.back()->ResetBit(kCanDelete);
-                }
-            }
-            c->setMultigraph(mgArray);
-            //c->setLegendArray(legArray);
-            uint index = 1;
-            for (uint i = 0; i < N_SPECTROMETERS; i++)
-            {
-                if (!checkButtonDrawSpectrometers[i]->IsDown())
-                        continue;
-                c->cd(index);
-                mgArray[N_FIRST_WORK_TIME_PAGE*NxUpdate*NyUpdate + index-1]->Draw("A");
-                //legArray[N_FIRST_WORK_TIME_PAGE*NxUpdate*NyUpdate + index-1]->Draw("");
-                //ThomsonDraw::createLegend(mgArray[N_FIRST_WORK_TIME_PAGE*NxUpdate*NyUpdate + index-1]);
-                index++;
-            }
-
-            c->Modified();
-            c->Update();
+            setSCanvasPages(c, [this, c, canvas_name, shot_from_several_shots](uint it, uint i, TSCanvasPage &page) {
+                ThomsonCounter *counter = getThomsonCounter(it, i, shot_from_several_shots);
+                TMultiGraph *mg = ThomsonDraw::createMultiGraph(groupName(canvas_name, i), spectrometerName(i));
+                ThomsonDraw::srf_draw(c, mg,counter->getSRF(), N_WORK_CHANNELS, counter->getLMin(), counter->getLMax(),
+                                     counter->getNLambda(), LAMBDA_REFERENCE, {counter->getT()}, {counter->getTheta()}, false, false);
+                page.mgArray.push_back(mg);
+            });
         }
-        if (checkButton(drawConvolution) && thomsonDraw)
+        if (checkButton(drawConvolution) && thomsonDraw && !isCanvasActual("convolution", DRAW_TABLES, spectrometersView))
         {
             TString canvas_name = "convolution";
             TCanvas *c = ThomsonDraw::createCanvas(canvas_name, canvasTitle(canvas_name), width, height, NxUpdate, NyUpdate);
@@ -1992,7 +1633,7 @@ void ThomsonGUI::DrawGraphs()
             c->Update();
         
         }
-        if (checkButton(drawSignalsInChannels) && signalDraw ) 
+        if (checkButton(drawSignalsInChannels) && signalDraw && !isCanvasActual("signal", DRAW_SIGNALS, spectrometersView)) 
         {
             TString canvas_name = "signal";
             // TCanvas *c = ThomsonDraw::createCanvas(canvas_name, canvasTitle(canvas_name, shotDiagnostic, nTimePage), width, height, NxUpdate, NyUpdate);
@@ -2016,45 +1657,14 @@ void ThomsonGUI::DrawGraphs()
                 titleArray[i] = canvasTitle(canvas_name, shotDiagnostic, i);
             c->setTitleArray(titleArray);
 
-            std::vector <TMultiGraph*> mgArray;
-            std::vector <TLegend*> legArray;
-            mgArray.reserve(NxUpdate*NyUpdate*N_TIME_LIST);
-            legArray.reserve(NxUpdate*NyUpdate*N_TIME_LIST);
-            for (uint it = 0; it < N_TIME_LIST; it++)
-            {
-                uint index = 1;
-                for (uint i = 0; i < N_SPECTROMETERS; i++)
-                {
-                    if (!checkButtonDrawSpectrometers[i]->IsDown())
-                        continue;
-                    c->cd(index);
-                    index++;
-                    TMultiGraph *mg = ThomsonDraw::createMultiGraph(groupName(canvas_name, i), spectrometerName(i));
-                    mg->ResetBit(kCanDelete);
-                    ThomsonDraw::thomson_signal_draw(c, mg, getSignalProcessing(it, i, shot_from_several_shots), 0, false, true, false, N_WORK_CHANNELS, work_mask[i]);
-                    mgArray.push_back(mg);
-                    legArray.push_back(ThomsonDraw::createLegend(mg, 0.18, 0.6, 0.35, 0.88, false));
-                    legArray.back()->ResetBit(kCanDelete);
-                }
-            }
-            c->setMultigraph(mgArray);
-            c->setLegendArray(legArray);
-            uint index = 1;
-            for (uint i = 0; i < N_SPECTROMETERS; i++)
-            {
-                if (!checkButtonDrawSpectrometers[i]->IsDown())
-                        continue;
-                c->cd(index);
-                mgArray[N_FIRST_WORK_TIME_PAGE*NxUpdate*NyUpdate + index-1]->Draw("A");
-                legArray[N_FIRST_WORK_TIME_PAGE*NxUpdate*NyUpdate + index-1]->Draw("");
-                //ThomsonDraw::createLegend(mgArray[N_FIRST_WORK_TIME_PAGE*NxUpdate*NyUpdate + index-1]);
-                index++;
-            }
-
-            c->Modified();
-            c->Update();
+            setSCanvasPages(c, [this, c, canvas_name, shot_from_several_shots](uint it, uint i, TSCanvasPage &page) {
+                TMultiGraph *mg = ThomsonDraw::createMultiGraph(groupName(canvas_name, i), spectrometerName(i));
+                ThomsonDraw::thomson_signal_draw(c, mg, getSignalProcessing(it, i, shot_from_several_shots), 0, false, false, false, N_WORK_CHANNELS, work_mask[i]);
+                page.mgArray.push_back(mg);
+                page.legendArray.push_back(ThomsonDraw::createLegend(mg, 0.18, 0.6, 0.35, 0.88, false));
+            });
         }
-        if (checkButton(drawIntegralInChannels) && signalDraw)
+        if (checkButton(drawIntegralInChannels) && signalDraw && !isCanvasActual("integral", DRAW_SIGNALS, spectrometersView))
         {
             TString canvas_name = "integral";
             // TCanvas *c = ThomsonDraw::createCanvas(canvas_name, canvasTitle(canvas_name, shotDiagnostic, nTimePage), width, height, NxUpdate, NyUpdate);
@@ -2076,46 +1686,14 @@ void ThomsonGUI::DrawGraphs()
                 titleArray[i] = canvasTitle(canvas_name, shotDiagnostic, i);
             c->setTitleArray(titleArray);
 
-            std::vector <TMultiGraph*> mgArray;
-            std::vector <TLegend*> legArray;
-            mgArray.reserve(NxUpdate*NyUpdate*N_TIME_LIST);
-            legArray.reserve(NxUpdate*NyUpdate*N_TIME_LIST);
-            for (uint it = 0; it < N_TIME_LIST; it++)
-            {
-                uint index = 1;
-                for (uint i = 0; i < N_SPECTROMETERS; i++)
-                {
-                    if (!checkButtonDrawSpectrometers[i]->IsDown())
-                        continue;
-                    c->cd(index);
-                    index++;
-                    TMultiGraph *mg = ThomsonDraw::createMultiGraph(groupName(canvas_name, i), spectrometerName(i));
-                    mg->ResetBit(kCanDelete);
-                    ThomsonDraw::thomson_signal_draw(c, mg, getSignalProcessing(it, i, shot_from_several_shots), 1, false, true, false, N_WORK_CHANNELS, work_mask[i]);
-                    mgArray.push_back(mg);
-                    legArray.push_back(ThomsonDraw::createLegend(mg, 0.18, 0.6, 0.35, 0.88, false));
-                    legArray.back()->ResetBit(kCanDelete);
-                }
-            }
-            c->setMultigraph(mgArray);
-            c->setLegendArray(legArray);
-            uint index = 1;
-            for (uint i = 0; i < N_SPECTROMETERS; i++)
-            {
-                if (!checkButtonDrawSpectrometers[i]->IsDown())
-                        continue;
-                c->cd(index);
-                mgArray[N_FIRST_WORK_TIME_PAGE*NxUpdate*NyUpdate + index-1]->Draw("A");
-                legArray[N_FIRST_WORK_TIME_PAGE*NxUpdate*NyUpdate + index-1]->Draw("");
-                //ThomsonDraw::createLegend(mgArray[N_FIRST_WORK_TIME_PAGE*NxUpdate*NyUpdate + index-1]);
-                index++;
-            }
-
-
-            c->Modified();
-            c->Update();
+            setSCanvasPages(c, [this, c, canvas_name, shot_from_several_shots](uint it, uint i, TSCanvasPage &page) {
+                TMultiGraph *mg = ThomsonDraw::createMultiGraph(groupName(canvas_name, i), spectrometerName(i));
+                ThomsonDraw::thomson_signal_draw(c, mg, getSignalProcessing(it, i, shot_from_several_shots), 1, false, false, false, N_WORK_CHANNELS, work_mask[i]);
+                page.mgArray.push_back(mg);
+                page.legendArray.push_back(ThomsonDraw::createLegend(mg, 0.18, 0.6, 0.35, 0.88, false));
+            });
         }
-        if (checkButton(drawSignalsAndIntegralsInChannels) && signalDraw)
+        if (checkButton(drawSignalsAndIntegralsInChannels) && signalDraw && !isCanvasActual("signal_integral", DRAW_SIGNALS, spectrometersView))
         {
             TString canvas_name = "signal_integral";
             // TCanvas *c = ThomsonDraw::createCanvas(canvas_name, canvasTitle(canvas_name, shotDiagnostic, nTimePage), width, height, NxUpdate, NyUpdate);
@@ -2139,48 +1717,16 @@ void ThomsonGUI::DrawGraphs()
                 titleArray[i] = canvasTitle(canvas_name, shotDiagnostic, i);
             c->setTitleArray(titleArray);
 
-            std::vector <TMultiGraph*> mgArray;
-            std::vector <TLegend*> legArray;
-            mgArray.reserve(NxUpdate*NyUpdate*N_TIME_LIST);
-            legArray.reserve(NxUpdate*NyUpdate*N_TIME_LIST);
-            for (uint it = 0; it < N_TIME_LIST; it++)
-            {
-                uint index = 1;
-                for (uint i = 0; i < N_SPECTROMETERS; i++)
-                {
-                    if (!checkButtonDrawSpectrometers[i]->IsDown())
-                        continue;
-                    c->cd(index);
-                    index++;
-                    TMultiGraph *mg = ThomsonDraw::createMultiGraph(groupName(canvas_name, i), spectrometerName(i));
-                    mg->ResetBit(kCanDelete);
-                    ThomsonDraw::thomson_signal_draw(c, mg, getSignalProcessing(it, i, shot_from_several_shots), 0, false, false, false, N_WORK_CHANNELS, work_mask[i], 10., false);
-                    mg->SetTitle(spectrometerName(i)); // чтобы использовать title для интеграла
-                    ThomsonDraw::thomson_signal_draw(c, mg, getSignalProcessing(it, i, shot_from_several_shots), 1, false, true, false, N_WORK_CHANNELS, work_mask[i]);
-                    mgArray.push_back(mg);
-                    legArray.push_back(ThomsonDraw::createLegend(mg, 0.18, 0.6, 0.35, 0.88, false));
-                    legArray.back()->ResetBit(kCanDelete);
-                }
-            }
-            c->setMultigraph(mgArray);
-            c->setLegendArray(legArray);
-            uint index = 1;
-            for (uint i = 0; i < N_SPECTROMETERS; i++)
-            {
-                if (!checkButtonDrawSpectrometers[i]->IsDown())
-                        continue;
-                c->cd(index);
-                mgArray[N_FIRST_WORK_TIME_PAGE*NxUpdate*NyUpdate + index-1]->Draw("A");
-                legArray[N_FIRST_WORK_TIME_PAGE*NxUpdate*NyUpdate + index-1]->Draw("");
-                //ThomsonDraw::createLegend(mgArray[N_FIRST_WORK_TIME_PAGE*NxUpdate*NyUpdate + index-1]);
-                index++;
-            }
-
-
-            c->Modified();
-            c->Update();
+            setSCanvasPages(c, [this, c, canvas_name, shot_from_several_shots](uint it, uint i, TSCanvasPage &page) {
+                TMultiGraph *mg = ThomsonDraw::createMultiGraph(groupName(canvas_name, i), spectrometerName(i));
+                ThomsonDraw::thomson_signal_draw(c, mg, getSignalProcessing(it, i, shot_from_several_shots), 0, false, false, false, N_WORK_CHANNELS, work_mask[i], 10., false);
+                mg->SetTitle(spectrometerName(i)); // чтобы использовать title для интеграла
+                ThomsonDraw::thomson_signal_draw(c, mg, getSignalProcessing(it, i, shot_from_several_shots), 1, false, false, false, N_WORK_CHANNELS, work_mask[i]);
+                page.mgArray.push_back(mg);
+                page.legendArray.push_back(ThomsonDraw::createLegend(mg, 0.18, 0.6, 0.35, 0.88, false));
+            });
         }
-        if (checkButton(drawCompareSignalAndResult)  && thomsonDraw)
+        if (checkButton(drawCompareSignalAndResult) && thomsonDraw && !isCanvasActual("synthetic_signal", DRAW_RESULTS, spectrometersView))
         {
             TString canvas_name = "synthetic_signal";
             // TCanvas *c = ThomsonDraw::createCanvas(canvas_name, canvasTitle(canvas_name, shotDiagnostic, nTimePage), width, height, NxUpdate, NyUpdate);
@@ -2203,52 +1749,18 @@ void ThomsonGUI::DrawGraphs()
                 titleArray[i] = canvasTitle(canvas_name, shotDiagnostic, i);
             c->setTitleArray(titleArray);
 
-            std::vector <THStack*> hsArray;
-            //std::vector <TLegend*> legArray;
-            hsArray.reserve(NxUpdate*NyUpdate*N_TIME_LIST);
-            //legArray.reserve(NxUpdate*NyUpdate*N_TIME_LIST);
-            for (uint it = 0; it < N_TIME_LIST; it++)
-            {
-                uint index = 1;
-                for (uint i = 0; i < N_SPECTROMETERS; i++)
-                {
-                    if (!checkButtonDrawSpectrometers[i]->IsDown())
-                        continue;
-                    c->cd(index);
-                    index++;
-                    ThomsonCounter *counter = getThomsonCounter(it, i, shot_from_several_shots);
-                    //TMultiGraph *mg = ThomsonDraw::createMultiGraph(groupName(canvas_name, i), spectrometerName(i));
-                    THStack *hs = ThomsonDraw::createHStack(groupName(canvas_name, i, "hs_"), spectrometerName(i, counter->getRMSE()));
-                    hs->ResetBit(kCanDelete);
-                    //mg->ResetBit(kCanDelete);
-                    ThomsonDraw::draw_compare_signals(c, hs, N_WORK_CHANNELS, counter->getSignal(), counter->getSignalError(), counter->getSignalResult(), counter->getWorkSignal(), false);
-                    hsArray.push_back(hs);
-                    //legArray.push_back(ThomsonDraw::createLegend(mg, 0.18, 0.6, 0.35, 0.88, false));
-                    //legArray.back()->ResetBit(kCanDelete);
-                }
-            }
-            c->setHStack(hsArray);
-            //c->setLegendArray(legArray);
-            uint index = 1;
-            for (uint i = 0; i < N_SPECTROMETERS; i++)
-            {
-                if (!checkButtonDrawSpectrometers[i]->IsDown())
-                        continue;
-                c->cd(index);
-                hsArray[N_FIRST_WORK_TIME_PAGE*NxUpdate*NyUpdate + index-1]->Draw("nostack HIST E1");
-                //legArray[N_FIRST_WORK_TIME_PAGE*NxUpdate*NyUpdate + index-1]->Draw("");
-                //ThomsonDraw::createLegend(mgArray[N_FIRST_WORK_TIME_PAGE*NxUpdate*NyUpdate + index-1]);
-                index++;
-            }
-
-            c->Modified();
-            c->Update();
+            setSCanvasPages(c, [this, c, canvas_name, shot_from_several_shots](uint it, uint i, TSCanvasPage &page) {
+                ThomsonCounter *counter = getThomsonCounter(it, i, shot_from_several_shots);
+                THStack *hs = ThomsonDraw::createHStack(groupName(canvas_name, i, "hs_"), spectrometerName(i, counter->getRMSE()));
+                ThomsonDraw::draw_compare_signals(c, hs, N_WORK_CHANNELS, counter->getSignal(), counter->getSignalError(), counter->getSignalResult(), counter->getWorkSignal(), false);
+                page.hsArray.push_back(hs);
+            });
         }
     }
 
     if (getNumberActiveCheck(checkButtonDrawTime) != 0) // если нажата хотя бы одна кнопка
     {
-        if (checkButton(drawEnergySignals) && signalDraw)
+        if (checkButton(drawEnergySignals) && signalDraw && !isCanvasActual("signal_laser_energy", DRAW_SIGNALS, timeView))
         {
             TString canvas_name = "signal_laser_energy";
             TCanvas *c = ThomsonDraw::createCanvas(canvas_name, canvasTitle(canvas_name, shotDiagnostic), width, height);
@@ -2279,7 +1791,7 @@ void ThomsonGUI::DrawGraphs()
             c->Update();
 
         }
-        if (checkButton(drawTemperatureRDependenceAll) && thomsonDraw)
+        if (checkButton(drawTemperatureRDependenceAll) && thomsonDraw && !isCanvasActual("Te_from_r", DRAW_RESULTS, timeView))
         {
             TString canvas_name = "Te_from_r";
             TCanvas *c = ThomsonDraw::createCanvas(canvas_name, canvasTitle(canvas_name, shotDiagnostic), width, height);
@@ -2311,7 +1823,7 @@ void ThomsonGUI::DrawGraphs()
             c->Modified();
             c->Update();
         }
-        if (checkButton(drawConcentrationRDependenceAll) && thomsonDraw)
+        if (checkButton(drawConcentrationRDependenceAll) && thomsonDraw && !isCanvasActual("ne_from_r", DRAW_RESULTS, timeView))
         {
             TString canvas_name = "ne_from_r";
             TCanvas *c = ThomsonDraw::createCanvas(canvas_name, canvasTitle(canvas_name, shotDiagnostic), width, height);
@@ -2346,7 +1858,7 @@ void ThomsonGUI::DrawGraphs()
     }
     if (getNumberActiveCheck(checkButtonDrawSpectrometersFromTime) != 0)
     {
-        if (checkButton(drawTeFromTime) && thomsonDraw)
+        if (checkButton(drawTeFromTime) && thomsonDraw && !isCanvasActual("Te_from_t", DRAW_RESULTS, spectrometersTimeView))
         {
             TString canvas_name = "Te_from_t";
             TCanvas *c = ThomsonDraw::createCanvas(canvas_name, canvasTitle(canvas_name, shotDiagnostic), width, height);
@@ -2381,7 +1893,7 @@ void ThomsonGUI::DrawGraphs()
             c->Update();
 
         }
-        if (checkButton(drawNeFromTime) && thomsonDraw)
+        if (checkButton(drawNeFromTime) && thomsonDraw && !isCanvasActual("ne_from_t", DRAW_RESULTS, spectrometersTimeView))
         {
             TString canvas_name = "ne_from_t";
             TCanvas *c = ThomsonDraw::createCanvas(canvas_name, canvasTitle(canvas_name, shotDiagnostic), width, height);
@@ -2422,6 +1934,9 @@ void ThomsonGUI::DrawGraphs()
 
 void ThomsonGUI::PrintInfo()
 {
+    if (isBusy())
+        return;
+
 
     if (countType == CountType::None)
         return;
@@ -2436,7 +1951,7 @@ void ThomsonGUI::PrintInfo()
 
     if (countType == CountType::SetOfShots)
     {
-        bool find = shotNumberFromSetOfShots(shot_from_several_shots, shotDiagnostic, shotNumber->GetNumber());
+        bool find = shotNumberFromSetOfShots(shot_from_several_shots, shotDiagnostic, shotNumber->GetNumber()) && loadShotFromSet(shot_from_several_shots);
         if (!find)
             return;
     }
@@ -2647,6 +2162,9 @@ void ThomsonGUI::RemoveAll()
 
 void ThomsonGUI::CountSeveralShot()
 {
+    if (isBusy())
+        return;
+
     TString fileName = mainFileTextEntry->GetText();
 
     std::ifstream fin;
@@ -2667,9 +2185,9 @@ void ThomsonGUI::CountSeveralShot()
         std::string processing_parameters;
         int type;
 
-        readFileInput(fin, srf_file_folder, convolution_file_folder, raman_file, archive_name, error_file_name, work_mask_string, processing_parameters, type);
+        pipeline.readFileInput(fin, srf_file_folder, convolution_file_folder, raman_file, archive_name, error_file_name, work_mask_string, processing_parameters, type);
 
-        readError(error_file_name.c_str(), sigmaCoeff);
+        pipeline.readError(error_file_name.c_str(), sigmaCoeff);
         readRamanCrossSection(raman_file.c_str());
 
         if (!fin.fail())
@@ -2677,7 +2195,7 @@ void ThomsonGUI::CountSeveralShot()
             std::cout << "обработка сигналов началась\n";
             for (uint i = 0; i < N_SPECTROMETERS; i++)
             {
-                barray mask = createWorkMask(work_mask_string[i]);
+                barray mask = pipeline.createWorkMask(work_mask_string[i]);
                 for (uint j = 0; j < N_CHANNELS; j++)
                     work_mask[i][j] = mask[j];
             }
@@ -2686,27 +2204,58 @@ void ThomsonGUI::CountSeveralShot()
             shotArray = createArrayShots(archive_name);
             N_SHOTS = shotArray.size();
 
-            std::vector <parray> parametersArray = readParametersToSignalProcessing(processing_parameters);
+            std::vector <parray> parametersArray = pipeline.readParametersToSignalProcessing(processing_parameters);
 
             if (!fin.fail() && shotArray.size() != 0)
             {
                 countType = CountType::SetOfShots;
 
-                clearSpArray();
-                clearCounterArray();
+                clearShots();
                 spArray.reserve(N_SPECTROMETERS*N_TIME_LIST*N_SHOTS);
                 counterArray.reserve(N_SPECTROMETERS*N_TIME_LIST*N_SHOTS);
-                uint index = 0;
-                for (uint shot : shotArray)
-                {
-                    changeStatusText(statusEntrySetOfShots, TString::Format("count start, shot %u", shot));
-                    // statusEntrySetOfShots->SetText(TString::Format("count start, shot %u", shot));
-                    // gClient->ForceRedraw();
-                    // gSystem->ProcessEvents();
-                    processingSignalsData(archive_name.c_str(), shot, parametersArray, false);
-                    countThomson(archive_name, srf_file_folder, convolution_file_folder, shot, false, type, index, cheakButtonCountThomsonSeveralShots->IsDown());
-                    index++;
-                }
+                arenas.reserve(N_SHOTS);
+
+                bool count = cheakButtonCountThomsonSeveralShots->IsDown();
+
+                ShotSettings settings;
+                settings.archive_name = archive_name;
+                settings.srf_file_folder = srf_file_folder;
+                settings.convolution_file_folder = convolution_file_folder;
+                settings.responseTables = useResponseTables->IsDown();
+                setTables(pipeline.tablesHash(settings));
+                settings.cache_folder = RESULT_CACHE_FOLDER;
+                settings.snapshot_folder = SNAPSHOT_FOLDER;
+                settings.parametersArray = parametersArray;
+                settings.sigmaCoeff = sigmaCoeff;
+                settings.work_mask = work_mask;
+                settings.selectionMethod = type;
+                settings.count = count;
+                if (useCalibrations->IsDown())
+                    settings.calibrations = getCalibration(archive_name.c_str(), 0, true, true);
+                if (useResultCache->IsDown())
+                    settings.configHash = pipeline.configurationHash(srf_file_folder, convolution_file_folder, error_file_name, processing_parameters, work_mask_string, type, count,
+                                                                     settings.responseTables);
+                shotSettings = settings;
+                statistics.reserve(N_SHOTS);
+
+                // пока выстрел фитируется, следующие уже читаются из архива
+                ResultTree tree(N_TIME_LIST);
+                if (writeResultTable->IsDown())
+                    tree.open(RESULT_TREE_FILE);
+
+                busy = true;
+                changeStatusText(statusEntrySetOfShots, TString::Format("count start, shot %u", shotArray.front()));
+                pipeline.run(settings, shotArray, queueDepthEntry->GetIntNumber(), [this, &tree](ShotItem &item) {
+                    statistics.addShot(item.spArray, item.counterArray);
+                    if (tree.isOpen())
+                        tree.add(item.shot, pipeline.createPages(item));
+                    addShotResult(item, item.index == 0); // выстрел 0 нужен для синтетических сигналов
+                    if ((uint) item.index+1 < shotArray.size())
+                        changeStatusText(statusEntrySetOfShots, TString::Format("count start, shot %u", shotArray[item.index+1]));
+                    return true;
+                });
+                busy = false;
+                tree.close();
             }
 
             statusEntrySetOfShots->SetText("ready");
@@ -2724,6 +2273,9 @@ void ThomsonGUI::CountSeveralShot()
 
 void ThomsonGUI::DrawSetOfShots()
 {
+    if (isBusy())
+        return;
+
     if (countType != CountType::SetOfShots)
         return;
 
@@ -2746,7 +2298,7 @@ void ThomsonGUI::DrawSetOfShots()
         darray xPosition(N_SPECTROMETERS, 0.);
         darray time_points(N_TIME_LIST, 0.);
 
-        meanThomsonData(N_SHOTS, TeFull, TeErrorFull, neFull, neErrorFull, xPosition, time_points);
+        statistics.meanThomsonData(TeFull, TeErrorFull, neFull, neErrorFull, xPosition, time_points);
 
         if (checkButton(drawTeSetOfShots)) 
         {
@@ -2880,22 +2432,7 @@ void ThomsonGUI::DrawSetOfShots()
     {
         if (checkButton(drawSignalStatisticSetofShots))
         {
-            darray signal;
-            signal.reserve(N_TIME_LIST*N_SHOTS);
-
-            for (uint in = 0; in < N_SHOTS; in++)
-            {
-                uint index = 0;
-                for (uint it = 0; it < N_TIME_LIST; it++)
-                {
-                    double E = getSignalProcessing(it, NUMBER_ENERGY_SPECTROMETER, in)->getSignals()[NUMBER_ENERGY_CHANNEL];
-                    if (checkButtonDrawTimeSetOfShots[index]->IsDown() && (Emax <= Emin || (E >= Emin && E <= Emax)))
-                        signal.push_back(getSignalProcessing(it, nSpectrometer, in)->getSignals()[nChannel]);
-                    index++;
-                    if (index == N_TIME_LIST)
-                        index = 0;
-                }
-            }
+            darray signal = statistics.signalSample(nSpectrometer, nChannel, timeMaskSetOfShots(), Emin, Emax, false);
 
             double min = minSignalEntry->GetNumber();
             double max = maxSignalEntry->GetNumber(); 
@@ -2922,21 +2459,7 @@ void ThomsonGUI::DrawSetOfShots()
         }
         if (checkButton(drawSignalToEnergyStatisticSetofShots))
         {
-            darray signal;
-            signal.reserve(N_TIME_LIST*N_SHOTS);
-            for (uint in = 0; in < N_SHOTS; in++)
-            {
-                uint index = 0;
-                for (uint it = 0; it < N_TIME_LIST; it++)
-                {
-                    double E = getSignalProcessing(it, NUMBER_ENERGY_SPECTROMETER, in)->getSignals()[NUMBER_ENERGY_CHANNEL];
-                    if (checkButtonDrawTimeSetOfShots[index]->IsDown() && (Emax <= Emin || (E >= Emin && E <= Emax)))
-                        signal.push_back(getSignalProcessing(it, nSpectrometer, in)->getSignals()[nChannel] / E);
-                    index++;
-                    if (index == N_TIME_LIST)
-                        index = 0;
-                }
-            }
+            darray signal = statistics.signalSample(nSpectrometer, nChannel, timeMaskSetOfShots(), Emin, Emax, true);
 
             double min = minSignalEntry->GetNumber();
             double max = maxSignalEntry->GetNumber(); 
@@ -2962,20 +2485,7 @@ void ThomsonGUI::DrawSetOfShots()
         }
         if (checkButton(drawEnergyStatisticSetofShots))
         {
-            darray signal;
-            signal.reserve(N_TIME_LIST*N_SHOTS);
-            for (uint in = 0; in < N_SHOTS; in++)
-            {
-                uint index = 0;
-                for (uint it = 0; it < N_TIME_LIST; it++)
-                {
-                    if (checkButtonDrawTimeSetOfShots[index]->IsDown())
-                        signal.push_back(getSignalProcessing(it, NUMBER_ENERGY_SPECTROMETER, in)->getSignals()[NUMBER_ENERGY_CHANNEL]);
-                    index++;
-                    if (index == N_TIME_LIST)
-                        index = 0;
-                }
-            }
+            darray signal = statistics.energySample(timeMaskSetOfShots());
 
             double min = minSignalEntry->GetNumber();
             double max = maxSignalEntry->GetNumber(); 
@@ -3005,6 +2515,9 @@ void ThomsonGUI::DrawSetOfShots()
 
 void ThomsonGUI::Calibrate()
 {
+    if (isBusy())
+        return;
+
     for (uint i = 0; i < N_WORK_CHANNELS; i++)
         channel_result[i]->SetNumber(-1);
 
@@ -3021,7 +2534,7 @@ void ThomsonGUI::Calibrate()
     {
         std::string temp;
         int t;
-        readFileInput(fin, srf_file, temp, raman_file, temp, temp, nullptr, temp, t);
+        pipeline.readFileInput(fin, srf_file, temp, raman_file, temp, temp, nullptr, temp, t);
 
         srf_file = srf_file + "SRF_Spectro-" + std::to_string(sp+1)+".dat";
         readRamanCrossSection(raman_file.c_str());
@@ -3077,6 +2590,9 @@ void ThomsonGUI::ClockClicked()
 
 void ThomsonGUI::Update()
 {
+    if (isBusy())
+        return;
+
     int shot = shotNumber->GetNumber();
     TString fileName = mainFileTextEntry->GetText();
 
@@ -3100,9 +2616,9 @@ void ThomsonGUI::Update()
             std::string work_mask_string[N_SPECTROMETERS];
             std::string processing_parameters;
             int type;
-            readFileInput(fin, srf_file_folder, convolution_file_folder, raman_file, archive_name, error_file_name, work_mask_string, processing_parameters, type);
+            pipeline.readFileInput(fin, srf_file_folder, convolution_file_folder, raman_file, archive_name, error_file_name, work_mask_string, processing_parameters, type);
             OpenArchive(archive_name.c_str());
-            shot = getShot(shot);
+            shot = pipeline.getShot(shot);
             CloseArchive();
             fin.close();
         }
@@ -3132,6 +2648,9 @@ void ThomsonGUI::Update()
 
 void ThomsonGUI::LoadRaman()
 {
+    if (isBusy())
+        return;
+
     if (countType != CountType::SetOfShots)
     {
         std::cerr << "выстрелы не обработаны\n";
@@ -3152,21 +2671,7 @@ void ThomsonGUI::LoadRaman()
     for (uint nChannel = 0; nChannel < 2; nChannel++)
     {
             channel_signal[nChannel]->SetNumber(-1);
-            darray signal;
-            signal.reserve(N_TIME_LIST*N_SHOTS);
-            for (uint in = 0; in < N_SHOTS; in++)
-            {
-                uint index = 0;
-                for (uint it = 0; it < N_TIME_LIST; it++)
-                {
-                    double E = getSignalProcessing(it, NUMBER_ENERGY_SPECTROMETER, in)->getSignals()[NUMBER_ENERGY_CHANNEL];
-                    if (checkButtonDrawTimeSetOfShots[index]->IsDown() && (Emax <= Emin || (E >= Emin && E <= Emax)))
-                        signal.push_back(getSignalProcessing(it, nSpectrometer, in)->getSignals()[nChannel] / E);
-                    index++;
-                    if (index == N_TIME_LIST)
-                        index = 0;
-                }
-            }
+            darray signal = statistics.signalSample(nSpectrometer, nChannel, timeMaskSetOfShots(), Emin, Emax, true);
 
             double mean = 0.;
             uint element = 0.;
@@ -3216,8 +2721,7 @@ ThomsonGUI::~ThomsonGUI()
     DeleteWindow();
     CloseWindow();
 
-    clearSpArray();
-    clearCounterArray();
+    clearShots();
 
     delete[] thetaCalibration;
     delete[] xPositionCalibration;
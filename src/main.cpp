@@ -1,11 +1,41 @@
 #include <iostream>
+#include <string>
 #include "ThomsonGUI.h"
+#include "CampaignRunner.h"
+#include "ThomsonSetup.h"
 
 
 int main(int argc, char**argv) 
 {
-    ThomsonGUI thomsonGUI(gClient->GetRoot(), 500, 600, new TApplication("app", &argc, argv), "Thomson", "thomson", 1064., 1000, 48, 11, 6, 8, 2, 7, 4, 6, 1, 10000);
+    std::string mode = argc > 1 ? argv[1] : "";
+
+    if (mode == "--worker" || mode == "--campaign" || mode == "--snapshot" || mode == "--tune") // обработка без GUI
+    {
+        ShotPipeline pipeline(THOMSON_SETUP);
+        CampaignRunner runner(pipeline);
+
+        if (mode == "--worker" && (argc == 6 || argc == 7))
+            return runner.runWorker(argv[2], std::stoul(argv[3]), std::stoul(argv[4]), argv[5], argc == 7 ? argv[6] : "");
+
+        if (mode == "--campaign" && (argc == 7 || argc == 8))
+            return runner.runCampaign("/proc/self/exe", argv[2], std::stoul(argv[3]), std::stoul(argv[4]), std::stoul(argv[5]), argv[6],
+                                      argc == 8 ? std::stoul(argv[7]) : 20);
+
+        if (mode == "--snapshot" && (argc == 5 || argc == 6))
+            return runner.runSnapshots(argv[2], std::stoul(argv[3]), std::stoul(argv[4]), argc == 6 ? argv[5] : "snapshots/");
+
+        if (mode == "--tune" && argc == 6)
+            return runner.runTuning(argv[2], std::stoul(argv[3]), std::stoul(argv[4]), argv[5]);
+
+        std::cerr << "usage: " << argv[0] << " --worker <input file> <first shot> <last shot> <result file> [snapshot folder]\n"
+                  << "       " << argv[0] << " --campaign <input file> <first shot> <last shot> <n proc (0 - all cores)> <result file> [shots in shard]\n"
+                  << "       " << argv[0] << " --snapshot <input file> <first shot> <last shot> [snapshot folder]\n"
+                  << "       " << argv[0] << " --tune <input file> <first shot> <last shot> <parameters file>\n";
+        return 1;
+    }
+
+    ThomsonGUI thomsonGUI(gClient->GetRoot(), 500, 600, new TApplication("app", &argc, argv), THOMSON_SETUP, 1, 10000);
     thomsonGUI.run();
 
     return 0;
-}
\ No newline at end of file
+}
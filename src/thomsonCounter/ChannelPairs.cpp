@@ -0,0 +1,53 @@
+#include "thomsonCounter/ChannelPairs.h"
+#include <map>
+#include <memory>
+#include <mutex>
+
+ChannelPairs::ChannelPairs(uint N_CHANNELS) : N_CHANNELS(N_CHANNELS), N_RATIO(N_CHANNELS*(N_CHANNELS-1)/2)
+{
+    pairs.reserve(N_RATIO);
+    index.assign(N_CHANNELS*N_CHANNELS, -1);
+    for (uint ch2 = 0; ch2 < N_CHANNELS; ch2++)
+    {
+        for (uint ch1 = 0; ch1 < ch2; ch1++)
+        {
+            index[ch1+ch2*N_CHANNELS] = pairs.size();
+            pairs.emplace_back(ch1, ch2);
+        }
+    }
+
+    share.resize(N_RATIO*N_RATIO);
+    for (uint ks = 0; ks < N_RATIO; ks++)
+    {
+        for (uint k = 0; k < N_RATIO; k++)
+        {
+            uint a[] = {pairs[k].first, pairs[k].second};
+            uint b[] = {pairs[ks].first, pairs[ks].second};
+
+            PairShare s = {-1, -1};
+            if (k == ks)
+                s = {2, 2};
+            else
+            {
+                // у разных пар не больше одного общего канала
+                for (int8_t i = 0; i < 2; i++)
+                    for (int8_t j = 0; j < 2; j++)
+                        if (a[i] == b[j])
+                            s = {i, j};
+            }
+            share[k+ks*N_RATIO] = s;
+        }
+    }
+}
+
+const ChannelPairs &ChannelPairs::get(uint N_CHANNELS)
+{
+    static std::mutex mutex;
+    static std::map <uint, std::unique_ptr<ChannelPairs>> topologies;
+
+    std::lock_guard <std::mutex> lock(mutex);
+    std::unique_ptr <ChannelPairs> &pairs = topologies[N_CHANNELS];
+    if (!pairs)
+        pairs.reset(new ChannelPairs(N_CHANNELS));
+    return *pairs;
+}
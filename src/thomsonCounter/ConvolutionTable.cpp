@@ -0,0 +1,288 @@
+#include "thomsonCounter/ConvolutionTable.h"
+#include "thomsonCounter/Spectrum.h"
+#include "thomsonCounter/SRF.h"
+#include "thomsonCounter/ResultCache.h"
+#include "thomsonCounter/FastMath.h"
+#include <fstream>
+#include <iostream>
+#include <cstdio>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <future>
+#include <map>
+
+#include <dirent.h>
+#include <utime.h>
+#include <sys/stat.h>
+
+#define CONVOLUTION_MAGIC 0x54435354u // "TSCT"
+#define CONVOLUTION_VERSION 2u // 2 - свертки по полосам SRF
+#define CONVOLUTION_TABLES_MAX 16 // таблиц в памяти процесса, дальше вытесняется давно не нужная
+#define CONVOLUTION_FILES_MAX 8 // файлов таблиц одного SRF в cache_folder (разные theta)
+
+namespace {
+
+template <class T>
+void writeValue(std::ostream &fout, const T &value)
+{
+    fout.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <class T>
+bool readValue(std::istream &fin, T &value)
+{
+    fin.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return !fin.fail();
+}
+
+std::string baseName(const std::string &file_name)
+{
+    size_t slash = file_name.find_last_of('/');
+    return slash == std::string::npos ? file_name : file_name.substr(slash+1);
+}
+
+// из файлов таблиц srf_file_name в cache_folder остаются CONVOLUTION_FILES_MAX последних по времени использования
+void pruneConvolutionCache(const std::string &cache_folder, const std::string &srf_file_name)
+{
+    DIR *dir = opendir(cache_folder.empty() ? "." : cache_folder.c_str());
+    if (dir == nullptr)
+        return;
+
+    const std::string prefix = baseName(srf_file_name) + "_";
+    const std::string suffix = ".convolution";
+    std::vector <std::pair<time_t, std::string>> files;
+    for (dirent *entry = readdir(dir); entry != nullptr; entry = readdir(dir))
+    {
+        std::string name = entry->d_name;
+        if (name.size() != prefix.size()+16+suffix.size() || name.compare(0, prefix.size(), prefix) != 0 ||
+            name.compare(name.size()-suffix.size(), suffix.size(), suffix) != 0)
+            continue;
+
+        struct stat st;
+        std::string file_name = cache_folder + name;
+        if (stat(file_name.c_str(), &st) == 0)
+            files.push_back({st.st_mtime, file_name});
+    }
+    closedir(dir);
+
+    if (files.size() <= CONVOLUTION_FILES_MAX)
+        return;
+
+    std::sort(files.begin(), files.end(), [](const std::pair<time_t, std::string> &a, const std::pair<time_t, std::string> &b) { return a.first > b.first; });
+    for (uint i = CONVOLUTION_FILES_MAX; i < files.size(); i++)
+        std::remove(files[i].second.c_str());
+}
+
+typedef std::shared_future <std::shared_ptr<const ConvolutionTable>> TableFuture;
+
+struct TableEntry
+{
+    TableFuture table; // готова, когда таблица прочитана или построена
+    uint64_t used; // время последнего обращения для вытеснения
+    uint64_t id;
+};
+
+}
+
+bool ConvolutionTable::build(const darray &SRF, uint N_CHANNELS, uint N_LAMBDA, double lMin, double lMax, double dl, double theta, double lambda_reference,
+                             const ConvolutionGrid &grid, uint threads)
+{
+    SCount.clear();
+    this->N_CHANNELS = 0;
+
+    if (grid.N_T == 0 || !(grid.T0 > 0.) || !(grid.dT > 0.) || N_CHANNELS == 0 || N_LAMBDA < 2 || SRF.size() < N_CHANNELS*N_LAMBDA)
+    {
+        std::cerr << "неверная сетка таблицы свертки или SRF!\n";
+        return false;
+    }
+
+    this->grid = grid;
+    this->N_CHANNELS = N_CHANNELS;
+    this->theta = theta;
+    this->lambda_reference = lambda_reference;
+
+    const uint N_T = grid.N_T;
+    SCount.assign(N_T*N_CHANNELS, 0.);
+
+    // спектр только в полосе пропускания каналов
+    SparseSRF srf;
+    srf.assign(SRF, N_CHANNELS, N_LAMBDA, lMin, lMax);
+    const SRFBand &band = srf.getUnion();
+
+    // узлы Te блоками, спектр в буфере потока
+    const uint BLOCK = 16;
+    std::atomic <uint> next(0);
+    auto worker = [&]() {
+        darray S(band.size);
+        const double A = SNorma(lambda_reference, theta);
+        for (uint first = BLOCK*next++; first < N_T; first = BLOCK*next++)
+        {
+            for (uint it = first; it < std::min(first+BLOCK, N_T); it++)
+            {
+                fillSArray(S.data(), band.size, lMin + band.first*dl, dl, countA(grid.T0 + it*grid.dT), A, theta, lambda_reference);
+                for (uint ch = 0; ch < N_CHANNELS; ch++)
+                    SCount[it+ch*N_T] = srf.convolution(ch, S.data(), band);
+            }
+        }
+    };
+
+    uint n_threads = threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+    n_threads = std::min(n_threads, (N_T+BLOCK-1)/BLOCK);
+    std::vector <std::thread> pool;
+    for (uint i = 0; i < n_threads; i++)
+        pool.emplace_back(worker);
+    for (std::thread &thread : pool)
+        thread.join();
+
+    return true;
+}
+
+bool ConvolutionTable::write(const std::string &file_name, uint64_t key) const
+{
+    std::string temp_name = file_name + ".tmp";
+
+    std::ofstream fout(temp_name, std::ios::binary);
+    if (!fout.is_open())
+    {
+        std::cerr << "не удалось записать таблицу свертки: " << temp_name << "!\n";
+        return false;
+    }
+
+    writeValue(fout, (uint32_t) CONVOLUTION_MAGIC);
+    writeValue(fout, (uint32_t) CONVOLUTION_VERSION);
+    writeValue(fout, key);
+    writeValue(fout, grid.T0);
+    writeValue(fout, grid.dT);
+    writeValue(fout, (uint32_t) grid.N_T);
+    writeValue(fout, (uint32_t) N_CHANNELS);
+    writeValue(fout, theta);
+    writeValue(fout, lambda_reference);
+    fout.write(reinterpret_cast<const char*>(SCount.data()), SCount.size()*sizeof(double));
+
+    fout.close();
+    if (fout.fail() || std::rename(temp_name.c_str(), file_name.c_str()) != 0)
+    {
+        std::remove(temp_name.c_str());
+        std::cerr << "не удалось записать таблицу свертки: " << file_name << "!\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool ConvolutionTable::read(const std::string &file_name, uint64_t key)
+{
+    std::ifstream fin(file_name, std::ios::binary);
+    if (!fin.is_open())
+        return false;
+
+    uint32_t magic, version, N_T, channels;
+    uint64_t file_key;
+    ConvolutionGrid file_grid;
+    double file_theta, reference;
+
+    if (!readValue(fin, magic) || !readValue(fin, version) || !readValue(fin, file_key) ||
+        !readValue(fin, file_grid.T0) || !readValue(fin, file_grid.dT) || !readValue(fin, N_T) ||
+        !readValue(fin, channels) || !readValue(fin, file_theta) || !readValue(fin, reference))
+        return false;
+
+    if (magic != CONVOLUTION_MAGIC || version != CONVOLUTION_VERSION || file_key != key || N_T == 0 || channels == 0)
+        return false;
+
+    darray values(N_T*channels);
+    fin.read(reinterpret_cast<char*>(values.data()), values.size()*sizeof(double));
+    if (fin.fail())
+        return false;
+
+    file_grid.N_T = N_T;
+    grid = file_grid;
+    N_CHANNELS = channels;
+    theta = file_theta;
+    lambda_reference = reference;
+    SCount.swap(values);
+    return true;
+}
+
+std::string convolutionCacheFileName(const std::string &cache_folder, const std::string &srf_file_name, uint64_t key)
+{
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", (unsigned long long) key);
+    return cache_folder + baseName(srf_file_name) + "_" + hex + ".convolution";
+}
+
+std::shared_ptr<const ConvolutionTable> ConvolutionTable::get(const std::string &srf_file_name, uint N_CHANNELS, double theta, double lambda_reference,
+                                                              const std::string &cache_folder, const ConvolutionGrid &grid)
+{
+    static std::mutex mutex;
+    static std::map <uint64_t, TableEntry> tables;
+    static uint64_t clock = 0;
+
+    uint64_t key = hashFile(srf_file_name);
+    key = hashBytes(&N_CHANNELS, sizeof(N_CHANNELS), key);
+    key = hashBytes(&theta, sizeof(theta), key);
+    key = hashBytes(&lambda_reference, sizeof(lambda_reference), key);
+    key = hashBytes(&grid.T0, sizeof(grid.T0), key);
+    key = hashBytes(&grid.dT, sizeof(grid.dT), key);
+    key = hashBytes(&grid.N_T, sizeof(grid.N_T), key);
+    int tier = getExpTier();
+    if (tier != EXP_STD) // таблица строится с тем же exp, что и спектр
+        key = hashBytes(&tier, sizeof(tier), key);
+
+    // таблица строится вне общей блокировки, остальные потоки с тем же ключом ждут ее готовности
+    std::promise <std::shared_ptr<const ConvolutionTable>> promise;
+    TableFuture ready;
+    uint64_t id = 0;
+    {
+        std::lock_guard <std::mutex> lock(mutex);
+        auto found = tables.find(key);
+        if (found != tables.end())
+        {
+            found->second.used = ++clock;
+            ready = found->second.table;
+        }
+        else
+        {
+            if (tables.size() >= CONVOLUTION_TABLES_MAX) // у кого вытесненная таблица уже есть, продолжают с ней работать
+                tables.erase(std::min_element(tables.begin(), tables.end(), [](const std::pair<const uint64_t, TableEntry> &a, const std::pair<const uint64_t, TableEntry> &b) {
+                    return a.second.used < b.second.used;
+                }));
+
+            id = ++clock;
+            tables[key] = {promise.get_future().share(), id, id};
+        }
+    }
+    if (ready.valid())
+        return ready.get();
+
+    std::shared_ptr <ConvolutionTable> created = std::make_shared<ConvolutionTable>();
+    std::string file_name = cache_folder.empty() ? "" : convolutionCacheFileName(cache_folder, srf_file_name, key);
+    if (!file_name.empty() && created->read(file_name, key))
+    {
+        utime(file_name.c_str(), nullptr); // файл использован, при чистке кэша остается
+    }
+    else
+    {
+        darray SRF;
+        double lMin, lMax, dl;
+        uint N_LAMBDA;
+        readSRF(srf_file_name, SRF, lMin, lMax, dl, N_LAMBDA, N_CHANNELS);
+        if (!created->build(SRF, N_CHANNELS, N_LAMBDA, lMin, lMax, dl, theta, lambda_reference, grid))
+        {
+            {
+                std::lock_guard <std::mutex> lock(mutex);
+                auto found = tables.find(key);
+                if (found != tables.end() && found->second.id == id)
+                    tables.erase(found);
+            }
+            promise.set_value(nullptr);
+            return nullptr;
+        }
+        if (!file_name.empty() && created->write(file_name, key))
+            pruneConvolutionCache(cache_folder, srf_file_name);
+    }
+
+    promise.set_value(created);
+    return created;
+}
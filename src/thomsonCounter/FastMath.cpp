@@ -0,0 +1,18 @@
+#include "thomsonCounter/FastMath.h"
+#include <atomic>
+
+namespace {
+
+std::atomic <int> expTier((int) THOMSON_EXP_TIER);
+
+}
+
+ExpTier getExpTier()
+{
+    return (ExpTier) expTier.load(std::memory_order_relaxed);
+}
+
+void setExpTier(ExpTier tier)
+{
+    expTier.store((int) tier, std::memory_order_relaxed);
+}
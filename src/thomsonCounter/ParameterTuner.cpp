@@ -0,0 +1,144 @@
+#include "thomsonCounter/ParameterTuner.h"
+#include <cmath>
+#include <algorithm>
+
+ParameterTuner::ParameterTuner(uint tSize, uint nSamples) : tSize(tSize), nSamples(nSamples), added(0),
+    P((tSize+1)*nSamples, 0.), Q((tSize+1)*nSamples, 0.), C((tSize+1)*nSamples, 0.), energy(nSamples, 0.)
+{
+}
+
+void ParameterTuner::addSample(const sample_t *t, const sample_t *U, double energy)
+{
+    if (added >= nSamples)
+        return;
+
+    const uint k = added++;
+    const uint n = nSamples;
+    this->energy[k] = energy;
+
+    // интеграл как в SignalProcessing::integrateSignal, но от первой точки и без нулевой линии
+    double R = 0.;
+    for (uint i = 0; i < tSize; i++)
+    {
+        if (i > 0)
+            R += ((double) t[i] - t[i-1]) * ((double) U[i] + U[i-1]) / 2.;
+        P[(i+1)*n+k] = P[i*n+k] + U[i];
+        Q[(i+1)*n+k] = Q[i*n+k] + R;
+        C[(i+1)*n+k] = C[i*n+k] + t[i];
+    }
+}
+
+double ParameterTuner::score(const SignalProcessingParameters &p, const std::pair<double, double> &sigmaCoeff) const
+{
+    const uint n = added;
+    const int N = tSize;
+    if (n == 0)
+        return HUGE_VAL;
+
+    // окна нулевой линии, как в findZeroLine, пересечение окон считается один раз
+    int a1 = std::min<int>(p.start_point_from_start_zero_line, N);
+    int a2 = std::min<int>(p.start_point_from_start_zero_line + p.step_from_start_zero_line, N);
+    int b1 = std::max(0, N - (int) p.start_point_from_end_zero_line - (int) p.step_from_end_zero_line);
+    int b2 = std::max(0, N - (int) p.start_point_from_end_zero_line);
+    int c1 = std::max(a1, b1);
+    int c2 = std::min(a2, b2);
+    if (c2 < c1)
+        c2 = c1;
+    bool useZero = p.step_from_start_zero_line != 0 || p.step_from_end_zero_line != 0;
+    int zeroCount = (a2-a1) + (b2-b1) - (c2-c1);
+    if (useZero && zeroCount <= 0)
+        return HUGE_VAL;
+
+    // окно сигнала, точки до point_integrate_start дают 0
+    int s = std::min<int>(p.signal_point_start, N);
+    int e = std::min<int>(p.signal_point_start + p.signal_point_step, N);
+    int W = e - s;
+    int pis = p.point_integrate_start;
+    if (W <= 0 || pis >= N)
+        return HUGE_VAL;
+    int i0 = std::min(std::max(s, pis+1), e);
+    double m = e - i0;
+
+    const double *Pa1 = &P[a1*n], *Pa2 = &P[a2*n], *Pb1 = &P[b1*n], *Pb2 = &P[b2*n], *Pc1 = &P[c1*n], *Pc2 = &P[c2*n];
+    const double *Qe = &Q[e*n], *Qi0 = &Q[i0*n], *Qp0 = &Q[pis*n], *Qp1 = &Q[(pis+1)*n];
+    const double *Ce = &C[e*n], *Ci0 = &C[i0*n], *Cp0 = &C[pis*n], *Cp1 = &C[(pis+1)*n];
+    const double *E = energy.data();
+    const double A0 = sigmaCoeff.first;
+    const double sigma0 = sigmaCoeff.second;
+
+    double sumS = 0., sumSS = 0., sumSE = 0., sumEE = 0., sumVar = 0.;
+    for (uint k = 0; k < n; k++)
+    {
+        double Z = useZero ? ((Pa2[k]-Pa1[k]) + (Pb2[k]-Pb1[k]) - (Pc2[k]-Pc1[k])) / zeroCount : 0.;
+        double Rp = Qp1[k] - Qp0[k];
+        double tp = Cp1[k] - Cp0[k];
+        double S = ((Qe[k]-Qi0[k]) - m*Rp - Z*((Ce[k]-Ci0[k]) - m*tp)) / W;
+
+        sumS += S;
+        sumSS += S*S;
+        sumSE += S*E[k];
+        sumEE += E[k]*E[k];
+        sumVar += sigma0*sigma0 + A0*A0*std::max(S, 0.);
+    }
+
+    double meanS = sumS/n;
+    if (!(meanS > 0.))
+        return HUGE_VAL;
+
+    double residual = sumEE > 0. ? sumSS - sumSE*sumSE/sumEE : sumSS - n*meanS*meanS;
+    return sqrt((std::max(residual, 0.) + sumVar) / n) / meanS;
+}
+
+TuneResult ParameterTuner::tune(const SignalProcessingParameters &start, const std::pair<double, double> &sigmaCoeff, const TuneGrid &grid) const
+{
+    TuneResult result;
+    result.parameters = start;
+    result.startScore = score(start, sigmaCoeff);
+    result.score = result.startScore;
+    result.settings = 1;
+
+    const int r = grid.radius;
+    const int stride = std::max(1u, grid.stride);
+    uiarray zeroSteps = grid.zeroSteps;
+    zeroSteps.push_back(start.step_from_start_zero_line);
+
+    SignalProcessingParameters p = start;
+    for (int pis = (int) start.point_integrate_start - r; pis <= (int) start.point_integrate_start + r; pis += stride)
+    {
+        if (pis < 0 || pis >= (int) tSize)
+            continue;
+        p.point_integrate_start = pis;
+
+        for (int sps = (int) start.signal_point_start - r; sps <= (int) start.signal_point_start + r; sps += stride)
+        {
+            if (sps <= pis || sps >= (int) tSize)
+                continue;
+            p.signal_point_start = sps;
+
+            for (uint step : grid.signalSteps)
+            {
+                if (sps + step > tSize)
+                    continue;
+                p.signal_point_step = step;
+
+                for (uint zs : zeroSteps)
+                {
+                    // нулевая линия до окна сигнала
+                    if (zs == 0 || start.start_point_from_start_zero_line + zs > (uint) sps)
+                        continue;
+                    p.step_from_start_zero_line = zs;
+
+                    double value = score(p, sigmaCoeff);
+                    result.settings++;
+                    if (value < result.score)
+                    {
+                        result.score = value;
+                        result.parameters = p;
+                    }
+                }
+            }
+        }
+    }
+
+    return result;
+}
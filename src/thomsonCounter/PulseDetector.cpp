@@ -0,0 +1,118 @@
+#include "thomsonCounter/PulseDetector.h"
+#include <cmath>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+PulseTemplate::PulseTemplate(const darray &shape) : shape(shape), energy(0.), peak(0)
+{
+    for (uint i = 0; i < this->shape.size(); i++)
+        if (this->shape[i] > this->shape[peak])
+            peak = i;
+
+    double max = this->shape.empty() ? 0. : this->shape[peak];
+    if (max > 0.)
+        for (double &s : this->shape)
+            s /= max;
+
+    for (double s : this->shape)
+        energy += s*s;
+}
+
+PulseTemplate PulseTemplate::gaussian(double width)
+{
+    double sigma = std::max(width, 1.) / (2.*sqrt(2.*log(2.)));
+    int half = (int) std::ceil(3.*sigma);
+
+    darray shape(2*half+1);
+    for (int i = -half; i <= half; i++)
+        shape[i+half] = exp(-0.5*i*i/(sigma*sigma));
+
+    return PulseTemplate(shape);
+}
+
+bool readPulseTemplate(const std::string &file_name, darray &shape)
+{
+    std::ifstream fin(file_name);
+    if (!fin.is_open())
+    {
+        std::cerr << "не удалось открыть файл шаблона импульса: " << file_name << "!\n";
+        return false;
+    }
+
+    shape.clear();
+    double value;
+    while (fin >> value)
+        shape.push_back(value);
+
+    if (shape.empty())
+    {
+        std::cerr << "пустой шаблон импульса: " << file_name << "!\n";
+        return false;
+    }
+
+    return true;
+}
+
+PulseMatch matchPulse(const sample_t *U, uint n, const PulseTemplate &pulse, const TimeAxis &timeAxis, uint channel, darray &buffer)
+{
+    PulseMatch match;
+    const uint m = pulse.size();
+    if (n < 2 || m == 0 || n < m || pulse.getEnergy() <= 0.)
+        return match;
+
+    // шум: 1.4826*MAD разностей / sqrt(2)
+    buffer.resize(n-1);
+    double q = 0.; // шаг квантования - наименьшая ненулевая разность
+    double sum2 = 0.;
+    for (uint i = 1; i < n; i++)
+    {
+        double d = std::abs((double) U[i] - U[i-1]);
+        buffer[i-1] = d;
+        sum2 += d*d;
+        if (d > 0. && (q == 0. || d < q))
+            q = d;
+    }
+    std::nth_element(buffer.begin(), buffer.begin()+buffer.size()/2, buffer.end());
+    match.noise = 1.4826*buffer[buffer.size()/2]/sqrt(2.);
+
+    // у тихого канала большая часть разностей оцифровки равна 0 и MAD = 0:
+    // тогда СКО разностей, и в любом случае не меньше шума квантования q/sqrt(12)
+    if (match.noise == 0.)
+        match.noise = sqrt(sum2/(n-1)/2.);
+    match.noise = std::max(match.noise, q/sqrt(12.));
+
+    // свертка по точкам шаблона: внутренний цикл - axpy по непрерывным массивам, векторизуется компилятором
+    const uint N_LAGS = n-m+1;
+    buffer.assign(N_LAGS, 0.);
+    double *c = buffer.data();
+    const double *s = pulse.getShape().data();
+    for (uint j = 0; j < m; j++)
+    {
+        const double sj = s[j];
+        const sample_t *u = U+j;
+        for (uint k = 0; k < N_LAGS; k++)
+            c[k] += sj*u[k];
+    }
+
+    uint k = std::max_element(c, c+N_LAGS) - c;
+
+    // максимум уточняется параболой по соседним точкам
+    double delta = 0.;
+    if (k > 0 && k+1 < N_LAGS)
+    {
+        double d2 = c[k-1] - 2.*c[k] + c[k+1];
+        if (d2 < 0.)
+            delta = 0.5*(c[k-1] - c[k+1]) / d2;
+    }
+
+    uint point = k + pulse.getPeak();
+    double sigma = match.noise*sqrt(pulse.getEnergy());
+
+    match.start = k;
+    match.amplitude = c[k] / pulse.getEnergy();
+    match.time = timeAxis.at(channel, point) + delta*(point > 0 ? timeAxis.step(channel, point) : timeAxis.step(channel, 1));
+    match.snr = sigma > 0. ? c[k] / sigma : 0.; // sigma = 0 только у постоянного сигнала, импульса нет
+
+    return match;
+}
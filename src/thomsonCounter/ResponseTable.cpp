@@ -0,0 +1,421 @@
+#include "thomsonCounter/ResponseTable.h"
+#include "thomsonCounter/Spectrum.h"
+#include "thomsonCounter/SRF.h"
+#include "thomsonCounter/ResultCache.h"
+#include "thomsonCounter/FastMath.h"
+#include <fstream>
+#include <iostream>
+#include <cstdio>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <map>
+
+#define RESPONSE_MAGIC 0x54525354u // "TSRT"
+#define RESPONSE_VERSION 2u // 2 - свертки по полосам SRF
+
+namespace {
+
+template <class T>
+void writeValue(std::ostream &fout, const T &value)
+{
+    fout.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <class T>
+bool readValue(std::istream &fin, T &value)
+{
+    fin.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return !fin.fail();
+}
+
+void writeGrid(std::ostream &fout, const ResponseGrid &grid)
+{
+    writeValue(fout, grid.TMin);
+    writeValue(fout, grid.TMax);
+    writeValue(fout, (uint32_t) grid.N_T);
+    writeValue(fout, grid.thetaMin);
+    writeValue(fout, grid.thetaMax);
+    writeValue(fout, (uint32_t) grid.N_THETA);
+}
+
+bool readGrid(std::istream &fin, ResponseGrid &grid)
+{
+    uint32_t N_T, N_THETA;
+    if (!readValue(fin, grid.TMin) || !readValue(fin, grid.TMax) || !readValue(fin, N_T) ||
+        !readValue(fin, grid.thetaMin) || !readValue(fin, grid.thetaMax) || !readValue(fin, N_THETA))
+        return false;
+    grid.N_T = N_T;
+    grid.N_THETA = N_THETA;
+    return true;
+}
+
+uint64_t hashGrid(const ResponseGrid &grid, uint64_t hash)
+{
+    hash = hashBytes(&grid.TMin, sizeof(grid.TMin), hash);
+    hash = hashBytes(&grid.TMax, sizeof(grid.TMax), hash);
+    hash = hashBytes(&grid.N_T, sizeof(grid.N_T), hash);
+    hash = hashBytes(&grid.thetaMin, sizeof(grid.thetaMin), hash);
+    hash = hashBytes(&grid.thetaMax, sizeof(grid.thetaMax), hash);
+    hash = hashBytes(&grid.N_THETA, sizeof(grid.N_THETA), hash);
+    return hash;
+}
+
+}
+
+bool ResponseTable::setGrid(const ResponseGrid &grid)
+{
+    if (grid.N_T < 4 || grid.N_THETA < 4 || !(grid.TMin > 0.) || !(grid.TMax > grid.TMin) || !(grid.thetaMax > grid.thetaMin))
+        return false;
+
+    this->grid = grid;
+    dx = (log(grid.TMax) - log(grid.TMin)) / (grid.N_T-1);
+    dtheta = (grid.thetaMax - grid.thetaMin) / (grid.N_THETA-1);
+    return true;
+}
+
+ResponseTable::Stencil ResponseTable::stencil(double x, uint n) const
+{
+    x = std::min(std::max(x, 0.), n-1.);
+    uint i = std::min((uint) x, n-2);
+    double u = x - i;
+    double u2 = u*u;
+    double u3 = u2*u;
+
+    // веса узлов i-1..i+2
+    double c[4] = {(-u3 + 2.*u2 - u)/2., (3.*u3 - 5.*u2 + 2.)/2., (-3.*u3 + 4.*u2 + u)/2., (u3 - u2)/2.};
+    double dc[4] = {(-3.*u2 + 4.*u - 1.)/2., (9.*u2 - 10.*u)/2., (-9.*u2 + 8.*u + 1.)/2., (3.*u2 - 2.*u)/2.};
+
+    Stencil s;
+    int base = (int) i - 1;
+    s.first = std::min(std::max(base, 0), (int) n-4);
+    std::fill(s.w, s.w+4, 0.);
+    std::fill(s.dw, s.dw+4, 0.);
+
+    auto add = [&](int node, double w, double dw) {
+        s.w[node-s.first] += w;
+        s.dw[node-s.first] += dw;
+    };
+
+    for (int k = 0; k < 4; k++)
+    {
+        int node = base + k;
+        // за краем сетки значения продолжаются линейно по двум крайним узлам
+        if (node < 0)
+        {
+            add(0, 2.*c[k], 2.*dc[k]);
+            add(1, -c[k], -dc[k]);
+        }
+        else if (node > (int) n-1)
+        {
+            add(n-1, 2.*c[k], 2.*dc[k]);
+            add(n-2, -c[k], -dc[k]);
+        }
+        else
+            add(node, c[k], dc[k]);
+    }
+
+    return s;
+}
+
+void ResponseTable::slice(const Stencil &sy, uint ch, double *S) const
+{
+    const uint N_T = grid.N_T;
+    const double *rows = Q.data() + ch*N_T*grid.N_THETA + sy.first*N_T;
+
+    std::fill(S, S+N_T, 0.);
+    for (uint b = 0; b < 4; b++)
+    {
+        const double *row = rows + b*N_T;
+        for (uint it = 0; it < N_T; it++)
+            S[it] += sy.w[b]*row[it];
+    }
+}
+
+bool ResponseTable::build(const darray &SRF, uint N_CHANNELS, uint N_LAMBDA, double lMin, double lMax, double dl, double lambda_reference,
+                          const ResponseGrid &grid, uint threads)
+{
+    Q.clear();
+    this->N_CHANNELS = 0;
+
+    if (!setGrid(grid) || N_CHANNELS == 0 || N_LAMBDA < 2 || SRF.size() < N_CHANNELS*N_LAMBDA)
+    {
+        std::cerr << "неверная сетка таблицы отклика или SRF!\n";
+        return false;
+    }
+
+    this->N_CHANNELS = N_CHANNELS;
+    this->lambda_reference = lambda_reference;
+
+    const uint N_T = grid.N_T;
+    const uint N_THETA = grid.N_THETA;
+    Q.assign(N_T*N_THETA*N_CHANNELS, 0.);
+
+    // спектр только в полосе пропускания каналов
+    SparseSRF srf;
+    srf.assign(SRF, N_CHANNELS, N_LAMBDA, lMin, lMax);
+    const SRFBand &band = srf.getUnion();
+
+    // строки theta независимы, номер следующей строки общий для потоков
+    std::atomic <uint> next(0);
+    auto worker = [&]() {
+        darray S(band.size);
+        for (uint ith = next++; ith < N_THETA; ith = next++)
+        {
+            double theta = grid.thetaMin + ith*dtheta;
+            double A = SNorma(lambda_reference, theta);
+            for (uint it = 0; it < N_T; it++)
+            {
+                fillSArray(S.data(), band.size, lMin + band.first*dl, dl, countA(getNodeT(it)), A, theta, lambda_reference);
+                for (uint ch = 0; ch < N_CHANNELS; ch++)
+                    Q[it+ith*N_T+ch*N_T*N_THETA] = srf.convolution(ch, S.data(), band);
+            }
+        }
+    };
+
+    uint n_threads = threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+    n_threads = std::min(n_threads, N_THETA);
+    std::vector <std::thread> pool;
+    for (uint i = 0; i < n_threads; i++)
+        pool.emplace_back(worker);
+    for (std::thread &thread : pool)
+        thread.join();
+
+    return true;
+}
+
+bool ResponseTable::write(const std::string &file_name, uint64_t key) const
+{
+    std::string temp_name = file_name + ".tmp";
+
+    std::ofstream fout(temp_name, std::ios::binary);
+    if (!fout.is_open())
+    {
+        std::cerr << "не удалось записать таблицу отклика: " << temp_name << "!\n";
+        return false;
+    }
+
+    writeValue(fout, (uint32_t) RESPONSE_MAGIC);
+    writeValue(fout, (uint32_t) RESPONSE_VERSION);
+    writeValue(fout, key);
+    writeGrid(fout, grid);
+    writeValue(fout, (uint32_t) N_CHANNELS);
+    writeValue(fout, lambda_reference);
+    writeValue(fout, (uint32_t) Q.size());
+    fout.write(reinterpret_cast<const char*>(Q.data()), Q.size()*sizeof(double));
+
+    fout.close();
+    if (fout.fail() || std::rename(temp_name.c_str(), file_name.c_str()) != 0)
+    {
+        std::remove(temp_name.c_str());
+        std::cerr << "не удалось записать таблицу отклика: " << file_name << "!\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool ResponseTable::read(const std::string &file_name, uint64_t key)
+{
+    std::ifstream fin(file_name, std::ios::binary);
+    if (!fin.is_open())
+        return false;
+
+    uint32_t magic, version, channels, size;
+    uint64_t file_key;
+    ResponseGrid file_grid;
+    double reference;
+
+    if (!readValue(fin, magic) || !readValue(fin, version) || !readValue(fin, file_key) || !readGrid(fin, file_grid) ||
+        !readValue(fin, channels) || !readValue(fin, reference) || !readValue(fin, size))
+        return false;
+
+    if (magic != RESPONSE_MAGIC || version != RESPONSE_VERSION || file_key != key || !setGrid(file_grid) ||
+        size != file_grid.N_T*file_grid.N_THETA*channels)
+        return false;
+
+    darray values(size);
+    fin.read(reinterpret_cast<char*>(values.data()), size*sizeof(double));
+    if (fin.fail())
+        return false;
+
+    N_CHANNELS = channels;
+    lambda_reference = reference;
+    Q.swap(values);
+    return true;
+}
+
+bool ResponseTable::contains(double Te, double theta) const
+{
+    return N_CHANNELS != 0 && Te >= grid.TMin && Te <= grid.TMax && theta >= grid.thetaMin && theta <= grid.thetaMax;
+}
+
+void ResponseTable::count(double Te, double theta, double *Q, double *dQ) const
+{
+    const uint N_T = grid.N_T;
+    const uint N_THETA = grid.N_THETA;
+    Stencil sx = stencil((log(Te) - log(grid.TMin)) / dx, N_T);
+    Stencil sy = stencil((theta - grid.thetaMin) / dtheta, N_THETA);
+
+    for (uint ch = 0; ch < N_CHANNELS; ch++)
+    {
+        double q = 0.;
+        double dq = 0.;
+        for (uint b = 0; b < 4; b++)
+        {
+            const double *row = this->Q.data() + ch*N_T*N_THETA + (sy.first+b)*N_T + sx.first;
+            double value = 0.;
+            double dvalue = 0.;
+            for (uint a = 0; a < 4; a++)
+            {
+                value += sx.w[a]*row[a];
+                dvalue += sx.dw[a]*row[a];
+            }
+            q += sy.w[b]*value;
+            dq += sy.w[b]*dvalue;
+        }
+
+        Q[ch] = q;
+        if (dQ)
+            dQ[ch] = dq / (dx*Te);
+    }
+}
+
+void ResponseTable::slice(double theta, darray &S) const
+{
+    const uint N_T = grid.N_T;
+    Stencil sy = stencil((theta - grid.thetaMin) / dtheta, grid.N_THETA);
+
+    S.resize(N_T*N_CHANNELS);
+    for (uint ch = 0; ch < N_CHANNELS; ch++)
+        slice(sy, ch, S.data()+ch*N_T);
+}
+
+double ResponseTable::solveRatio(uint ch1, uint ch2, double ratio, double theta, double Te0, double epsilon, uint iter_limit, bool &success) const
+{
+    success = false;
+    const uint N_T = grid.N_T;
+    if (ch1 >= N_CHANNELS || ch2 >= N_CHANNELS || !contains(grid.TMin, theta))
+        return Te0;
+
+    Stencil sy = stencil((theta - grid.thetaMin) / dtheta, grid.N_THETA);
+    darray S1(N_T);
+    darray S2(N_T);
+    slice(sy, ch1, S1.data());
+    slice(sy, ch2, S2.data());
+
+    // пересечение с ratio между соседними узлами, ближайшее к Te0
+    double x0 = (log(Te0) - log(grid.TMin)) / dx;
+    int cell = -1;
+    for (uint it = 0; it+1 < N_T; it++)
+    {
+        double fa = S2[it]/S1[it] - ratio;
+        double fb = S2[it+1]/S1[it+1] - ratio;
+        if (!std::isfinite(fa) || !std::isfinite(fb) || fa*fb > 0.)
+            continue;
+        if (cell < 0 || std::abs(it+0.5-x0) < std::abs(cell+0.5-x0))
+            cell = it;
+    }
+
+    if (cell < 0)
+        return Te0;
+
+    auto f = [&](double x) {
+        Stencil sx = stencil(x, N_T);
+        double q1 = 0.;
+        double q2 = 0.;
+        for (uint a = 0; a < 4; a++)
+        {
+            q1 += sx.w[a]*S1[sx.first+a];
+            q2 += sx.w[a]*S2[sx.first+a];
+        }
+        return q2/q1 - ratio;
+    };
+
+    // метод Illinois внутри ячейки, точность по ln Te
+    double a = cell;
+    double b = cell+1.;
+    double fa = f(a);
+    double fb = f(b);
+    double x = fa == 0. ? a : b;
+    int side = 0;
+    const uint limit = std::min(iter_limit, 100u);
+    for (uint iter = 0; iter < limit && fa != 0. && fb != 0. && (b-a)*dx > epsilon; iter++)
+    {
+        x = (a*fb - b*fa) / (fb - fa);
+        double fx = f(x);
+        if (!std::isfinite(fx))
+            return Te0;
+
+        if (fx*fb > 0.)
+        {
+            b = x;
+            fb = fx;
+            if (side == -1)
+                fa /= 2.;
+            side = -1;
+        }
+        else if (fx*fa > 0.)
+        {
+            a = x;
+            fa = fx;
+            if (side == 1)
+                fb /= 2.;
+            side = 1;
+        }
+        else
+            break;
+    }
+
+    success = true;
+    return exp(log(grid.TMin) + x*dx);
+}
+
+std::string responseFileName(const std::string &cache_folder, const std::string &srf_file_name)
+{
+    size_t slash = srf_file_name.find_last_of('/');
+    std::string name = slash == std::string::npos ? srf_file_name : srf_file_name.substr(slash+1);
+    return cache_folder + name + ".response";
+}
+
+std::shared_ptr<const ResponseTable> ResponseTable::get(const std::string &srf_file_name, uint N_CHANNELS, double lambda_reference,
+                                                        const std::string &cache_folder, const ResponseGrid &grid)
+{
+    static std::mutex mutex;
+    static std::map <uint64_t, std::shared_ptr<const ResponseTable>> tables;
+
+    // ключ по содержимому SRF, изменившийся файл дает новую таблицу
+    uint64_t key = hashFile(srf_file_name);
+    key = hashBytes(&N_CHANNELS, sizeof(N_CHANNELS), key);
+    key = hashBytes(&lambda_reference, sizeof(lambda_reference), key);
+    key = hashGrid(grid, key);
+    int tier = getExpTier();
+    if (tier != EXP_STD) // таблица строится с тем же exp, что и спектр
+        key = hashBytes(&tier, sizeof(tier), key);
+
+    std::lock_guard <std::mutex> lock(mutex);
+    std::shared_ptr <const ResponseTable> &table = tables[key];
+    if (table)
+        return table;
+
+    std::shared_ptr <ResponseTable> created = std::make_shared<ResponseTable>();
+    std::string file_name = cache_folder.empty() ? "" : responseFileName(cache_folder, srf_file_name);
+    if (file_name.empty() || !created->read(file_name, key))
+    {
+        darray SRF;
+        double lMin, lMax, dl;
+        uint N_LAMBDA;
+        readSRF(srf_file_name, SRF, lMin, lMax, dl, N_LAMBDA, N_CHANNELS);
+        if (!created->build(SRF, N_CHANNELS, N_LAMBDA, lMin, lMax, dl, lambda_reference, grid))
+        {
+            tables.erase(key);
+            return nullptr;
+        }
+        if (!file_name.empty())
+            created->write(file_name, key);
+    }
+
+    table = created;
+    return table;
+}
@@ -0,0 +1,211 @@
+#include "thomsonCounter/ResultCache.h"
+#include <fstream>
+#include <iostream>
+#include <cstdio>
+
+#define CACHE_MAGIC 0x43525354u // "TSRC"
+#define CACHE_VERSION 1u
+
+namespace {
+
+template <class T>
+void writeValue(std::ostream &fout, const T &value)
+{
+    fout.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <class T>
+bool readValue(std::istream &fin, T &value)
+{
+    fin.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return !fin.fail();
+}
+
+void writeArray(std::ostream &fout, const darray &array)
+{
+    uint32_t size = array.size();
+    writeValue(fout, size);
+    fout.write(reinterpret_cast<const char*>(array.data()), size*sizeof(double));
+}
+
+bool readArray(std::istream &fin, darray &array)
+{
+    uint32_t size;
+    if (!readValue(fin, size))
+        return false;
+    array.resize(size);
+    fin.read(reinterpret_cast<char*>(array.data()), size*sizeof(double));
+    return !fin.fail();
+}
+
+void writeMask(std::ostream &fout, const barray &mask)
+{
+    uint32_t size = mask.size();
+    writeValue(fout, size);
+    for (uint i = 0; i < size; i++)
+        writeValue(fout, (char) mask[i]);
+}
+
+bool readMask(std::istream &fin, barray &mask)
+{
+    uint32_t size;
+    if (!readValue(fin, size))
+        return false;
+    mask.resize(size);
+    for (uint i = 0; i < size; i++)
+    {
+        char value;
+        if (!readValue(fin, value))
+            return false;
+        mask[i] = value != 0;
+    }
+    return true;
+}
+
+}
+
+uint64_t hashBytes(const void *data, size_t size, uint64_t hash)
+{
+    const unsigned char *bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+uint64_t hashString(const std::string &str, uint64_t hash)
+{
+    return hashBytes(str.data(), str.size(), hash);
+}
+
+uint64_t hashArray(const darray &array, uint64_t hash)
+{
+    return hashBytes(array.data(), array.size()*sizeof(double), hash);
+}
+
+uint64_t hashFile(const std::string &file_name, uint64_t hash)
+{
+    hash = hashString(file_name, hash);
+
+    std::ifstream fin(file_name, std::ios::binary);
+    if (!fin.is_open())
+        return hash;
+
+    char buffer[1 << 14];
+    while (fin.read(buffer, sizeof(buffer)) || fin.gcount() > 0)
+        hash = hashBytes(buffer, fin.gcount(), hash);
+
+    return hash;
+}
+
+void writePage(std::ostream &fout, const PageResult &page)
+{
+    writeArray(fout, page.signals);
+    writeArray(fout, page.signals_sigma);
+    writeMask(fout, page.work_signal);
+    writeValue(fout, page.coeff_to_energy);
+
+    writeValue(fout, page.theta);
+    writeArray(fout, page.Ki);
+    writeValue(fout, page.energy);
+    writeValue(fout, page.time_point);
+    writeValue(fout, page.x_position);
+
+    writeValue(fout, page.Te);
+    writeValue(fout, page.TeError);
+    writeValue(fout, page.ne);
+    writeValue(fout, page.neError);
+    writeValue(fout, page.rmse);
+    writeValue(fout, page.rmsePlus);
+    writeValue(fout, page.rmseMinus);
+
+    writeArray(fout, page.signalResult);
+    writeArray(fout, page.signalResultPlus);
+    writeArray(fout, page.signalResultMinus);
+}
+
+bool readPage(std::istream &fin, PageResult &page)
+{
+    return readArray(fin, page.signals) && readArray(fin, page.signals_sigma) && readMask(fin, page.work_signal) &&
+           readValue(fin, page.coeff_to_energy) &&
+           readValue(fin, page.theta) && readArray(fin, page.Ki) && readValue(fin, page.energy) &&
+           readValue(fin, page.time_point) && readValue(fin, page.x_position) &&
+           readValue(fin, page.Te) && readValue(fin, page.TeError) && readValue(fin, page.ne) && readValue(fin, page.neError) &&
+           readValue(fin, page.rmse) && readValue(fin, page.rmsePlus) && readValue(fin, page.rmseMinus) &&
+           readArray(fin, page.signalResult) && readArray(fin, page.signalResultPlus) && readArray(fin, page.signalResultMinus);
+}
+
+uint64_t shotCacheKey(uint64_t configHash, const std::string &archive_name, const darray &calibrations)
+{
+    return hashArray(calibrations, hashString(archive_name, configHash));
+}
+
+std::string cacheFileName(const std::string &cache_folder, int shot)
+{
+    return cache_folder + "shot_" + std::to_string(shot) + ".cache";
+}
+
+bool writeShotCache(const std::string &cache_folder, int shot, uint64_t key, const rarray &pages)
+{
+    std::string file_name = cacheFileName(cache_folder, shot);
+    std::string temp_name = file_name + ".tmp";
+
+    std::ofstream fout(temp_name, std::ios::binary);
+    if (!fout.is_open())
+    {
+        std::cerr << "не удалось записать кэш: " << temp_name << "!\n";
+        return false;
+    }
+
+    writeValue(fout, (uint32_t) CACHE_MAGIC);
+    writeValue(fout, (uint32_t) CACHE_VERSION);
+    writeValue(fout, key);
+    writeValue(fout, (int32_t) shot);
+    writeValue(fout, (uint32_t) pages.size());
+
+    for (const PageResult &page : pages)
+        writePage(fout, page);
+
+    fout.close();
+    if (fout.fail() || std::rename(temp_name.c_str(), file_name.c_str()) != 0)
+    {
+        std::remove(temp_name.c_str());
+        std::cerr << "не удалось записать кэш: " << file_name << "!\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool readShotCache(const std::string &cache_folder, int shot, uint64_t key, rarray &pages)
+{
+    pages.clear();
+
+    std::ifstream fin(cacheFileName(cache_folder, shot), std::ios::binary);
+    if (!fin.is_open())
+        return false;
+
+    uint32_t magic, version, size;
+    uint64_t file_key;
+    int32_t file_shot;
+
+    if (!readValue(fin, magic) || !readValue(fin, version) || !readValue(fin, file_key) || !readValue(fin, file_shot) || !readValue(fin, size))
+        return false;
+
+    if (magic != CACHE_MAGIC || version != CACHE_VERSION || file_key != key || file_shot != shot)
+        return false;
+
+    pages.resize(size);
+    for (PageResult &page : pages)
+    {
+        if (!readPage(fin, page))
+        {
+            pages.clear();
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,228 @@
+#include "thomsonCounter/ResultSet.h"
+#include <iostream>
+#include <algorithm>
+#include <cstdio>
+
+#define RESULT_SET_MAGIC 0x53525354u // "TSRS"
+#define RESULT_SET_VERSION 1u
+
+namespace {
+
+template <class T>
+void writeValue(std::ostream &fout, const T &value)
+{
+    fout.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <class T>
+bool readValue(std::istream &fin, T &value)
+{
+    fin.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return !fin.fail();
+}
+
+bool readShot(std::istream &fin, uint64_t offset, int shot, rarray &pages)
+{
+    int32_t file_shot;
+    uint32_t size;
+
+    fin.seekg(offset);
+    if (!readValue(fin, file_shot) || !readValue(fin, size) || file_shot != shot)
+        return false;
+
+    pages.resize(size);
+    for (PageResult &page : pages)
+        if (!readPage(fin, page))
+            return false;
+
+    return true;
+}
+
+}
+
+ResultSetWriter::~ResultSetWriter()
+{
+    if (fout.is_open())
+    {
+        fout.close();
+        std::remove(temp_name.c_str());
+    }
+}
+
+bool ResultSetWriter::open(const std::string &file_name)
+{
+    this->file_name = file_name;
+    temp_name = file_name + ".tmp";
+    index.clear();
+
+    fout.open(temp_name, std::ios::binary);
+    if (!fout.is_open())
+    {
+        std::cerr << "не удалось открыть файл: " << temp_name << "!\n";
+        return false;
+    }
+
+    writeValue(fout, (uint32_t) RESULT_SET_MAGIC);
+    writeValue(fout, (uint32_t) RESULT_SET_VERSION);
+    return !fout.fail();
+}
+
+bool ResultSetWriter::add(int shot, const rarray &pages)
+{
+    if (!fout.is_open())
+        return false;
+
+    index.emplace_back(shot, (uint64_t) fout.tellp());
+    writeValue(fout, (int32_t) shot);
+    writeValue(fout, (uint32_t) pages.size());
+    for (const PageResult &page : pages)
+        writePage(fout, page);
+
+    return !fout.fail();
+}
+
+bool ResultSetWriter::close()
+{
+    if (!fout.is_open())
+        return false;
+
+    uint64_t index_offset = fout.tellp();
+    for (const std::pair<int32_t, uint64_t> &it : index)
+    {
+        writeValue(fout, it.first);
+        writeValue(fout, it.second);
+    }
+    writeValue(fout, (uint32_t) index.size());
+    writeValue(fout, index_offset);
+    writeValue(fout, (uint32_t) RESULT_SET_MAGIC);
+
+    fout.close();
+    if (fout.fail() || std::rename(temp_name.c_str(), file_name.c_str()) != 0)
+    {
+        std::remove(temp_name.c_str());
+        std::cerr << "не удалось записать файл: " << file_name << "!\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool readResultSetIndex(const std::string &file_name, std::vector<std::pair<int32_t, uint64_t>> &index)
+{
+    index.clear();
+
+    std::ifstream fin(file_name, std::ios::binary);
+    if (!fin.is_open())
+        return false;
+
+    uint32_t magic, version, size, end_magic;
+    uint64_t index_offset;
+
+    if (!readValue(fin, magic) || !readValue(fin, version) || magic != RESULT_SET_MAGIC || version != RESULT_SET_VERSION)
+        return false;
+
+    fin.seekg(-(std::streamoff) (2*sizeof(uint32_t)+sizeof(uint64_t)), std::ios::end);
+    if (!readValue(fin, size) || !readValue(fin, index_offset) || !readValue(fin, end_magic) || end_magic != RESULT_SET_MAGIC)
+        return false;
+
+    fin.seekg(index_offset);
+    index.resize(size);
+    for (std::pair<int32_t, uint64_t> &it : index)
+    {
+        if (!readValue(fin, it.first) || !readValue(fin, it.second))
+        {
+            index.clear();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool readResultSetShot(const std::string &file_name, int shot, rarray &pages)
+{
+    pages.clear();
+
+    std::vector <std::pair<int32_t, uint64_t>> index;
+    if (!readResultSetIndex(file_name, index))
+        return false;
+
+    auto it = std::find_if(index.begin(), index.end(), [shot](const std::pair<int32_t, uint64_t> &p) { return p.first == shot; });
+    if (it == index.end())
+        return false;
+
+    std::ifstream fin(file_name, std::ios::binary);
+    if (!readShot(fin, it->second, shot, pages))
+    {
+        pages.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool readResultSet(const std::string &file_name, const std::function<bool(int shot, const rarray &pages)> &consumer)
+{
+    std::vector <std::pair<int32_t, uint64_t>> index;
+    if (!readResultSetIndex(file_name, index))
+        return false;
+
+    std::ifstream fin(file_name, std::ios::binary);
+    rarray pages;
+    for (const std::pair<int32_t, uint64_t> &entry : index)
+    {
+        if (!readShot(fin, entry.second, entry.first, pages))
+        {
+            std::cerr << "ошибка чтения выстрела " << entry.first << " из " << file_name << "!\n";
+            return false;
+        }
+        if (!consumer(entry.first, pages))
+            return false;
+    }
+
+    return true;
+}
+
+bool mergeResultSets(const std::vector<std::string> &file_names, const std::string &out_file_name)
+{
+    struct Entry { int32_t shot; uint64_t offset; uint file; };
+    std::vector <Entry> entries;
+
+    for (uint i = 0; i < file_names.size(); i++)
+    {
+        std::vector <std::pair<int32_t, uint64_t>> index;
+        if (!readResultSetIndex(file_names[i], index))
+        {
+            std::cerr << "не удалось прочитать файл: " << file_names[i] << "!\n";
+            return false;
+        }
+        for (const std::pair<int32_t, uint64_t> &it : index)
+            entries.push_back({it.first, it.second, i});
+    }
+
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.shot < b.shot; });
+
+    std::vector <std::ifstream> files(file_names.size());
+    for (uint i = 0; i < file_names.size(); i++)
+        files[i].open(file_names[i], std::ios::binary);
+
+    ResultSetWriter writer;
+    if (!writer.open(out_file_name))
+        return false;
+
+    rarray pages;
+    for (uint i = 0; i < entries.size(); i++)
+    {
+        const Entry &entry = entries[i];
+        if (i != 0 && entries[i-1].shot == entry.shot)
+            continue;
+
+        if (!readShot(files[entry.file], entry.offset, entry.shot, pages) || !writer.add(entry.shot, pages))
+        {
+            std::cerr << "ошибка при объединении, shot " << entry.shot << "!\n";
+            return false;
+        }
+    }
+
+    return writer.close();
+}
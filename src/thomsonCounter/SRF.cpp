@@ -3,6 +3,8 @@
 #include <string>
 #include <sstream>
 #include <iostream>
+#include <algorithm>
+#include <cmath>
 
 
 bool readSRF(std::string filename, darray &SRF, double &lMin, double &lMax, double &dl, uint &N_LAMBDA, uint N_CHANNELS) 
@@ -130,4 +132,70 @@ bool readSRF(std::string filename, darray &SRF, double &lMin, double &lMax, doub
 
     fin.close();
     return true;
-}
\ No newline at end of file
+}
+
+void SparseSRF::assign(const darray &SRF, uint N_CHANNELS, uint N_LAMBDA, double lMin, double lMax, double tolerance)
+{
+    this->N_LAMBDA = N_LAMBDA;
+    this->lMin = lMin;
+    dl = N_LAMBDA > 1 ? (lMax - lMin) / (N_LAMBDA-1) : 0.;
+    bands.assign(N_CHANNELS, SRFBand{0, 0, 0});
+    values.clear();
+    all = SRFBand{0, 0, 0};
+
+    uint all_last = 0;
+    for (uint ch = 0; ch < N_CHANNELS; ch++)
+    {
+        const double *srf = SRF.data() + ch*N_LAMBDA;
+
+        double max = 0.;
+        for (uint i = 0; i < N_LAMBDA; i++)
+            max = std::max(max, std::abs(srf[i]));
+        if (max == 0.)
+            continue;
+
+        uint first = 0;
+        uint last = N_LAMBDA-1;
+        while (std::abs(srf[first]) <= tolerance*max)
+            first++;
+        while (std::abs(srf[last]) <= tolerance*max)
+            last--;
+
+        SRFBand &band = bands[ch];
+        band = SRFBand{first, last-first+1, (uint) values.size()};
+
+        // трапеции по всей сетке: вес 1/2 только на концах сетки, вне полосы SRF ноль
+        for (uint i = first; i <= last; i++)
+            values.push_back(srf[i] * dl * (i == 0 || i == N_LAMBDA-1 ? 0.5 : 1.));
+
+        if (all.size == 0 || first < all.first)
+            all.first = first;
+        all_last = std::max(all_last, last);
+        all.size = all_last - all.first + 1;
+    }
+}
+
+SRFBand SparseSRF::getUnion(uint ch1, uint ch2) const
+{
+    const SRFBand &b1 = bands[ch1];
+    const SRFBand &b2 = bands[ch2];
+    if (b1.size == 0)
+        return b2;
+    if (b2.size == 0)
+        return b1;
+
+    uint first = std::min(b1.first, b2.first);
+    return SRFBand{first, std::max(b1.last(), b2.last()) - first + 1, 0};
+}
+
+double SparseSRF::convolution(uint ch, const double *S, const SRFBand &band) const
+{
+    const SRFBand &b = bands[ch];
+    const double *srf = values.data() + b.offset;
+    const double *s = S + (b.first - band.first);
+
+    double result = 0.;
+    for (uint i = 0; i < b.size; i++)
+        result += srf[i]*s[i];
+    return result;
+}
@@ -0,0 +1,38 @@
+#include "thomsonCounter/ShotArena.h"
+
+ShotArena::~ShotArena()
+{
+    for (SignalProcessing *it : spStorage)
+        delete it;
+    for (ThomsonCounter *it : counterStorage)
+        delete it;
+}
+
+ShotArena *ShotArenaPool::acquire()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (arenas.empty())
+        return new ShotArena();
+
+    ShotArena *arena = arenas.back();
+    arenas.pop_back();
+    return arena;
+}
+
+void ShotArenaPool::release(ShotArena *arena)
+{
+    if (arena == nullptr)
+        return;
+
+    arena->reset();
+    std::lock_guard<std::mutex> lock(mutex);
+    arenas.push_back(arena);
+}
+
+void ShotArenaPool::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (ShotArena *arena : arenas)
+        delete arena;
+    arenas.clear();
+}
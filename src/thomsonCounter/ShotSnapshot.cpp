@@ -0,0 +1,366 @@
+#include "thomsonCounter/ShotSnapshot.h"
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SHOT_SNAPSHOT_MAGIC 0x53535354u // "TSSS"
+#define SHOT_SNAPSHOT_VERSION 2u // 2 - имя архива в заголовке
+
+namespace {
+
+enum BlockType : uint8_t
+{
+    BLOCK_DOUBLE = 0,
+    BLOCK_LINEAR = 1, // x0 + i*dx
+    BLOCK_FLOAT = 2,
+    BLOCK_DELTA16 = 3 // (c0 + сумма разностей)*q
+};
+
+template <class T>
+void writeValue(std::ostream &fout, const T &value)
+{
+    fout.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <class T>
+void writeArray(std::ostream &fout, const T *data, size_t size)
+{
+    fout.write(reinterpret_cast<const char*>(data), size*sizeof(T));
+}
+
+// чтение из отображенного файла с проверкой границ
+class Reader
+{
+private:
+    const char *data;
+    size_t size;
+    size_t position;
+
+public:
+    Reader(const char *data, size_t size) : data(data), size(size), position(0) {}
+
+    template <class T>
+    bool read(T &value) { return read(&value, 1); }
+
+    template <class T>
+    bool read(T *values, size_t n)
+    {
+        if (n*sizeof(T) > size-position)
+            return false;
+        memcpy(values, data+position, n*sizeof(T));
+        position += n*sizeof(T);
+        return true;
+    }
+
+    size_t remaining() const { return size-position; }
+};
+
+// самый короткий блок канала - линейная сетка: тип, x0, dx
+#define MIN_BLOCK_SIZE (sizeof(uint8_t)+2*sizeof(double))
+
+bool isLinear(const double *x, uint n, double &x0, double &dx)
+{
+    x0 = n > 0 ? x[0] : 0.;
+    dx = n > 1 ? x[1]-x[0] : 0.;
+    for (uint i = 0; i < n; i++)
+        if (x0 + i*dx != x[i])
+            return false;
+    return true;
+}
+
+bool isDelta16(const double *x, uint n, int64_t &c0, double &q, std::vector <int16_t> &delta)
+{
+    q = 0.;
+    for (uint i = 1; i < n; i++)
+    {
+        double d = fabs(x[i]-x[i-1]);
+        if (d > 0. && (q == 0. || d < q))
+            q = d;
+    }
+    if (q == 0. || !std::isfinite(q))
+        return false;
+
+    delta.resize(n > 0 ? n-1 : 0);
+    int64_t c = 0;
+    for (uint i = 0; i < n; i++)
+    {
+        double code = std::round(x[i]/q);
+        if (!std::isfinite(code) || fabs(code) > 9e15 || code*q != x[i])
+            return false;
+
+        int64_t ci = (int64_t) code;
+        if (i == 0)
+            c0 = ci;
+        else if (ci-c < INT16_MIN || ci-c > INT16_MAX)
+            return false;
+        else
+            delta[i-1] = ci-c;
+        c = ci;
+    }
+    return true;
+}
+
+bool isFloat(const double *x, uint n)
+{
+    for (uint i = 0; i < n; i++)
+        if ((double) (float) x[i] != x[i] && !std::isnan(x[i]))
+            return false;
+    return true;
+}
+
+void writeBlock(std::ostream &fout, const double *x, uint n)
+{
+    double x0, dx;
+    int64_t c0;
+    double q;
+    std::vector <int16_t> delta;
+
+    if (isLinear(x, n, x0, dx))
+    {
+        writeValue(fout, (uint8_t) BLOCK_LINEAR);
+        writeValue(fout, x0);
+        writeValue(fout, dx);
+    }
+    else if (n > 6 && isDelta16(x, n, c0, q, delta))
+    {
+        writeValue(fout, (uint8_t) BLOCK_DELTA16);
+        writeValue(fout, c0);
+        writeValue(fout, q);
+        writeArray(fout, delta.data(), delta.size());
+    }
+    else if (isFloat(x, n))
+    {
+        writeValue(fout, (uint8_t) BLOCK_FLOAT);
+        std::vector <float> values(x, x+n);
+        writeArray(fout, values.data(), n);
+    }
+    else
+    {
+        writeValue(fout, (uint8_t) BLOCK_DOUBLE);
+        writeArray(fout, x, n);
+    }
+}
+
+bool readBlock(Reader &reader, double *x, uint n)
+{
+    uint8_t type;
+    if (!reader.read(type))
+        return false;
+
+    switch (type)
+    {
+    case BLOCK_LINEAR:
+    {
+        double x0, dx;
+        if (!reader.read(x0) || !reader.read(dx))
+            return false;
+        for (uint i = 0; i < n; i++)
+            x[i] = x0 + i*dx;
+        return true;
+    }
+    case BLOCK_DELTA16:
+    {
+        int64_t c;
+        double q;
+        std::vector <int16_t> delta(n > 0 ? n-1 : 0);
+        if (!reader.read(c) || !reader.read(q) || !reader.read(delta.data(), delta.size()))
+            return false;
+        for (uint i = 0; i < n; i++)
+        {
+            if (i > 0)
+                c += delta[i-1];
+            x[i] = (double) c * q;
+        }
+        return true;
+    }
+    case BLOCK_FLOAT:
+    {
+        std::vector <float> values(n);
+        if (!reader.read(values.data(), n))
+            return false;
+        std::copy(values.begin(), values.end(), x);
+        return true;
+    }
+    case BLOCK_DOUBLE:
+        return reader.read(x, n);
+    default:
+        return false;
+    }
+}
+
+#ifdef THOMSON_FLOAT_SAMPLES
+// отсчеты float: блок проверяется и разбирается в double
+void writeBlock(std::ostream &fout, const float *x, uint n)
+{
+    darray values(x, x+n);
+    writeBlock(fout, values.data(), n);
+}
+
+bool readBlock(Reader &reader, float *x, uint n)
+{
+    darray values(n);
+    if (!readBlock(reader, values.data(), n))
+        return false;
+    std::copy(values.begin(), values.end(), x);
+    return true;
+}
+#endif
+
+}
+
+bool writeShotSnapshot(const std::string &file_name, const ShotSnapshot &snapshot)
+{
+    const uint N_PAGES = snapshot.N_TIME_LIST*snapshot.N_SPECTROMETERS;
+    const uint PAGE_SIZE = snapshot.N_CHANNELS*snapshot.N_TIME_SIZE;
+
+    if (snapshot.t.size() != N_PAGES || snapshot.U.size() != N_PAGES || snapshot.time_points.size() != snapshot.N_TIME_LIST)
+    {
+        std::cerr << "неполные данные выстрела " << snapshot.shot << ", снимок не записан!\n";
+        return false;
+    }
+    for (uint i = 0; i < N_PAGES; i++)
+    {
+        if (snapshot.t[i].size() != PAGE_SIZE || snapshot.U[i].size() != PAGE_SIZE)
+        {
+            std::cerr << "неполные данные выстрела " << snapshot.shot << ", снимок не записан!\n";
+            return false;
+        }
+    }
+
+    std::string temp_name = file_name + ".tmp";
+    std::ofstream fout(temp_name, std::ios::binary);
+    if (!fout.is_open())
+    {
+        std::cerr << "не удалось открыть файл: " << temp_name << "!\n";
+        return false;
+    }
+
+    writeValue(fout, (uint32_t) SHOT_SNAPSHOT_MAGIC);
+    writeValue(fout, (uint32_t) SHOT_SNAPSHOT_VERSION);
+    writeValue(fout, (int32_t) snapshot.shot);
+    writeValue(fout, (uint32_t) snapshot.archive_name.size());
+    writeArray(fout, snapshot.archive_name.data(), snapshot.archive_name.size());
+    writeValue(fout, (uint32_t) snapshot.N_TIME_LIST);
+    writeValue(fout, (uint32_t) snapshot.N_SPECTROMETERS);
+    writeValue(fout, (uint32_t) snapshot.N_CHANNELS);
+    writeValue(fout, (uint32_t) snapshot.N_TIME_SIZE);
+    writeValue(fout, (uint32_t) snapshot.calibrations.size());
+    writeArray(fout, snapshot.calibrations.data(), snapshot.calibrations.size());
+    writeArray(fout, snapshot.time_points.data(), snapshot.time_points.size());
+
+    for (uint i = 0; i < N_PAGES; i++)
+    {
+        for (uint ch = 0; ch < snapshot.N_CHANNELS; ch++)
+        {
+            writeBlock(fout, snapshot.t[i].data()+ch*snapshot.N_TIME_SIZE, snapshot.N_TIME_SIZE);
+            writeBlock(fout, snapshot.U[i].data()+ch*snapshot.N_TIME_SIZE, snapshot.N_TIME_SIZE);
+        }
+    }
+
+    fout.close();
+    if (fout.fail() || std::rename(temp_name.c_str(), file_name.c_str()) != 0)
+    {
+        std::cerr << "не удалось записать файл: " << file_name << "!\n";
+        std::remove(temp_name.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool readShotSnapshot(const std::string &file_name, ShotSnapshot &snapshot, const std::string &archive_name,
+                      uint N_TIME_LIST, uint N_SPECTROMETERS, uint N_CHANNELS, uint N_TIME_SIZE)
+{
+    int fd = open(file_name.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return false;
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+
+    Reader reader(static_cast<const char*>(data), st.st_size);
+    uint32_t magic, version, name_size, N_CALIBRATIONS;
+    int32_t shot;
+    uint32_t sizes[4];
+
+    bool success = reader.read(magic) && reader.read(version) && magic == SHOT_SNAPSHOT_MAGIC && version == SHOT_SNAPSHOT_VERSION &&
+                   reader.read(shot) && reader.read(name_size) && name_size <= reader.remaining();
+
+    std::string file_archive_name;
+    if (success)
+    {
+        file_archive_name.resize(name_size);
+        success = reader.read(&file_archive_name[0], name_size) && reader.read(sizes, 4) && reader.read(N_CALIBRATIONS);
+    }
+
+    bool other = false;
+    if (success)
+    {
+        if (file_archive_name != archive_name)
+        {
+            std::cerr << "снимок " << file_name << " из архива " << file_archive_name << ", а не " << archive_name << "\n";
+            other = true;
+        }
+        else if (sizes[0] != N_TIME_LIST || sizes[1] != N_SPECTROMETERS || sizes[2] != N_CHANNELS || sizes[3] != N_TIME_SIZE)
+        {
+            std::cerr << "снимок " << file_name << " другого формата\n";
+            other = true;
+        }
+    }
+
+    // размеры из заголовка сравниваются с остатком файла до выделения памяти
+    const uint64_t N_PAGES = (uint64_t) N_TIME_LIST*N_SPECTROMETERS;
+    const uint64_t PAGE_SIZE = (uint64_t) N_CHANNELS*N_TIME_SIZE;
+    success = success && !other &&
+              (uint64_t) N_CALIBRATIONS + N_TIME_LIST <= reader.remaining() / sizeof(double) &&
+              N_PAGES*N_CHANNELS*2 <= (reader.remaining() - ((uint64_t) N_CALIBRATIONS + N_TIME_LIST)*sizeof(double)) / MIN_BLOCK_SIZE;
+
+    if (success)
+    {
+        snapshot.shot = shot;
+        snapshot.archive_name = file_archive_name;
+        snapshot.N_TIME_LIST = N_TIME_LIST;
+        snapshot.N_SPECTROMETERS = N_SPECTROMETERS;
+        snapshot.N_CHANNELS = N_CHANNELS;
+        snapshot.N_TIME_SIZE = N_TIME_SIZE;
+
+        snapshot.calibrations.resize(N_CALIBRATIONS);
+        snapshot.time_points.resize(N_TIME_LIST);
+        success = reader.read(snapshot.calibrations.data(), N_CALIBRATIONS) && reader.read(snapshot.time_points.data(), N_TIME_LIST);
+
+        snapshot.t.resize(N_PAGES);
+        snapshot.U.resize(N_PAGES);
+        for (uint i = 0; i < N_PAGES && success; i++)
+        {
+            snapshot.t[i].resize(PAGE_SIZE);
+            snapshot.U[i].resize(PAGE_SIZE);
+            for (uint ch = 0; ch < N_CHANNELS && success; ch++)
+                success = readBlock(reader, snapshot.t[i].data()+ch*N_TIME_SIZE, N_TIME_SIZE) &&
+                          readBlock(reader, snapshot.U[i].data()+ch*N_TIME_SIZE, N_TIME_SIZE);
+        }
+    }
+
+    munmap(data, st.st_size);
+
+    if (!success && !other)
+        std::cerr << "файл снимка поврежден: " << file_name << "!\n";
+    return success;
+}
@@ -0,0 +1,119 @@
+#include "thomsonCounter/ShotStatistics.h"
+#include <cmath>
+
+void WeightedMean::add(double value, double sigma)
+{
+    double w = 1./(sigma*sigma);
+
+    if (!std::isfinite(w) || std::isnan(value))
+    {
+        valid = false;
+        return;
+    }
+
+    if (w == 0.)
+        return;
+
+    sum_w += w;
+    mean += w/sum_w*(value-mean);
+}
+
+ShotStatistics::ShotStatistics(uint N_TIME_LIST, uint N_SPECTROMETERS, uint N_CHANNELS, uint NUMBER_ENERGY_SPECTROMETER, uint NUMBER_ENERGY_CHANNEL) :
+    N_TIME_LIST(N_TIME_LIST), N_SPECTROMETERS(N_SPECTROMETERS), N_CHANNELS(N_CHANNELS),
+    NUMBER_ENERGY_SPECTROMETER(NUMBER_ENERGY_SPECTROMETER), NUMBER_ENERGY_CHANNEL(NUMBER_ENERGY_CHANNEL)
+{
+    clear();
+}
+
+void ShotStatistics::clear()
+{
+    N_SHOTS = 0;
+    xPosition.assign(N_SPECTROMETERS, RunningMean());
+    timePoints.assign(N_TIME_LIST, RunningMean());
+    Te.assign(N_TIME_LIST*N_SPECTROMETERS, WeightedMean());
+    ne.assign(N_TIME_LIST*N_SPECTROMETERS, WeightedMean());
+    signals.clear();
+    signals.shrink_to_fit();
+}
+
+void ShotStatistics::reserve(uint N_SHOTS)
+{
+    signals.reserve(N_SHOTS*N_TIME_LIST*N_SPECTROMETERS*N_CHANNELS);
+}
+
+void ShotStatistics::addShot(const std::vector<SignalProcessing *> &spArray, const std::vector<ThomsonCounter *> &counterArray)
+{
+    signals.resize(signals.size()+N_TIME_LIST*N_SPECTROMETERS*N_CHANNELS, 0.);
+
+    for (uint sp = 0; sp < N_SPECTROMETERS; sp++)
+    {
+        xPosition[sp].add(counterArray[sp*N_TIME_LIST]->getXPositon());
+
+        for (uint it = 0; it < N_TIME_LIST; it++)
+        {
+            const ThomsonCounter *counter = counterArray[it+sp*N_TIME_LIST];
+            Te[sp+it*N_SPECTROMETERS].add(counter->getT(), counter->getTError());
+            ne[sp+it*N_SPECTROMETERS].add(counter->getN(), counter->getNError());
+
+            const darray &signal = spArray[it+sp*N_TIME_LIST]->getSignals();
+            double *row = &signals[N_CHANNELS*(sp+N_SPECTROMETERS*(it+N_TIME_LIST*N_SHOTS))];
+            for (uint ch = 0; ch < N_CHANNELS && ch < signal.size(); ch++)
+                row[ch] = signal[ch];
+        }
+    }
+
+    for (uint it = 0; it < N_TIME_LIST; it++)
+        timePoints[it].add(counterArray[it+NUMBER_ENERGY_SPECTROMETER*N_TIME_LIST]->getTimePoint());
+
+    N_SHOTS++;
+}
+
+void ShotStatistics::meanThomsonData(darray &Te, darray &TeError, darray &ne, darray &neError, darray &xPosition, darray &time_points) const
+{
+    for (uint sp = 0; sp < N_SPECTROMETERS; sp++)
+        xPosition[sp] = this->xPosition[sp].mean;
+
+    for (uint it = 0; it < N_TIME_LIST; it++)
+        time_points[it] = timePoints[it].mean;
+
+    for (uint index = 0; index < N_TIME_LIST*N_SPECTROMETERS; index++)
+    {
+        // как при прямом суммировании: nan в Te или ne обнуляет все четыре значения
+        bool valid = this->Te[index].isValid() && this->ne[index].isValid();
+        Te[index] = valid ? this->Te[index].getMean() : 0.;
+        TeError[index] = valid ? this->Te[index].getError() : 0.;
+        ne[index] = valid ? this->ne[index].getMean() : 0.;
+        neError[index] = valid ? this->ne[index].getError() : 0.;
+    }
+}
+
+darray ShotStatistics::signalSample(uint sp, uint ch, const barray &time_mask, double Emin, double Emax, bool toEnergy) const
+{
+    darray sample;
+    sample.reserve(N_TIME_LIST*N_SHOTS);
+
+    for (uint in = 0; in < N_SHOTS; in++)
+    {
+        for (uint it = 0; it < N_TIME_LIST; it++)
+        {
+            double E = getEnergy(it, in);
+            if (time_mask[it] && (Emax <= Emin || (E >= Emin && E <= Emax)))
+                sample.push_back(toEnergy ? getSignal(it, sp, ch, in) / E : getSignal(it, sp, ch, in));
+        }
+    }
+
+    return sample;
+}
+
+darray ShotStatistics::energySample(const barray &time_mask) const
+{
+    darray sample;
+    sample.reserve(N_TIME_LIST*N_SHOTS);
+
+    for (uint in = 0; in < N_SHOTS; in++)
+        for (uint it = 0; it < N_TIME_LIST; it++)
+            if (time_mask[it])
+                sample.push_back(getEnergy(it, in));
+
+    return sample;
+}
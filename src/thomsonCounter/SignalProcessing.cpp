@@ -1,32 +1,53 @@
 #include "thomsonCounter/SignalProcessing.h"
 #include <cmath>
 #include <iostream>
+#include <algorithm>
 
-void SignalProcessing::integrateSignal(const darray &t, const darray &U, uint channel, double UZero, uint point_integrate_start)
+void SignalProcessing::integrateSignal(const sarray &U, uint channel, double UZero, uint point_integrate_start)
 {
     uint index_0 = channel*tSize;
+    double integral = 0.; // сумма в double, в массив записывается с точностью sample_t
     UTintegrate_full[index_0] = 0.;
+
+    if (timeAxis.isUniform())
+    {
+        // постоянный шаг выносится из суммы
+        double dt = timeAxis.getStep(channel);
+        for (uint i = 1; i < tSize; i++)
+        {
+            if (i > point_integrate_start)
+            {
+                integral += ((double) U[index_0 + i] + U[index_0 + i-1]) / 2. - UZero;
+                UTintegrate_full[index_0+i] = dt * integral;
+            }
+            else
+                UTintegrate_full[index_0+i] = 0;
+        }
+        return;
+    }
+
     for (uint i = 1; i < tSize; i++)
     {
         if (i > point_integrate_start)
         {
-            double dt = t[index_0+i] - t[index_0 + i-1];
-            double Umean = (U[index_0 + i] + U[index_0 + i-1]) / 2. - UZero;
+            double dt = timeAxis.step(channel, i);
+            double Umean = ((double) U[index_0 + i] + U[index_0 + i-1]) / 2. - UZero;
             
-            UTintegrate_full[index_0+i] = UTintegrate_full[index_0 + i-1] + dt * Umean;
+            integral += dt * Umean;
+            UTintegrate_full[index_0+i] = integral;
         }
         else
             UTintegrate_full[index_0+i] = 0;
     }
 }
 
-void SignalProcessing::shiftSignal(const darray &U, uint channel, double UZero)
+void SignalProcessing::shiftSignal(const sarray &U, uint channel, double UZero)
 {
     for (uint i = 0; i < tSize; i++)
         UShift[i+channel*tSize] = U[i+channel*tSize] - UZero;
 }
 
-double SignalProcessing::countChannelSignal(const darray &UTintegrate, uint channel, uint signal_point_start, uint signal_point_step) const
+double SignalProcessing::countChannelSignal(const sarray &UTintegrate, uint channel, uint signal_point_start, uint signal_point_step) const
 {
     uint signal_point_step_real = 0;
 
@@ -59,7 +80,7 @@ double SignalProcessing::countChannelSignalSigma(double signal, const std::vecto
     return sigma;
 }
 
-double SignalProcessing::findZeroLine(const darray &t, const darray &U, uint channel, uint step_from_start_zero_line, uint step_from_end_zero_line, uint start_point_from_start_zero_line, uint start_point_from_end_zero_line) const
+double SignalProcessing::findZeroLine(const sarray &U, uint channel, uint step_from_start_zero_line, uint step_from_end_zero_line, uint start_point_from_start_zero_line, uint start_point_from_end_zero_line) const
 {
     double shift = 0.;
 
@@ -82,7 +103,7 @@ double SignalProcessing::findZeroLine(const darray &t, const darray &U, uint cha
     return shift/use_points;
 }
 
-SignalProcessingParameters SignalProcessing::parametersAdaptive(const SignalProcessingParameters &par, const darray &t, const darray &U, uint channel)
+SignalProcessingParameters SignalProcessing::parametersAdaptive(const SignalProcessingParameters &par, const sarray &U, uint channel)
 {
     SignalProcessingParameters parameters = par;
     uint index = channel*tSize;
@@ -96,28 +117,18 @@ SignalProcessingParameters SignalProcessing::parametersAdaptive(const SignalProc
         if (Umax < U[index+i])
         {
             Umax = U[index+i];
-            tmax = t[index+i];
+            tmax = timeAxis.at(channel, i);
         }
     }
 
     double t1 = tmax - t_minus;
     double t2 = tmax + t_plus;
 
-    int i_start = -1;
-    int i_end = -1;
-
-
-    for (uint i = 0; i < tSize; i++)
-    {
-        if (t[index+i] >= t1 && i_start < 0)
-        {
-            i_start = i;
-        }
-        if (t[index+i] >= t2 && i_end < 0)
-        {
-            i_end = i;
-        }
-    }
+    // при равномерной сетке индекс находится сразу, без просмотра массива
+    uint i1 = timeAxis.lowerBound(channel, t1);
+    uint i2 = timeAxis.lowerBound(channel, t2);
+    int i_start = i1 < tSize ? (int) i1 : -1;
+    int i_end = i2 < tSize ? (int) i2 : -1;
 
     //std::cout << t1 << " " << tmax << " " << t2 << " " << i_start << " " << i_end << "\n";
 
@@ -149,7 +160,7 @@ SignalProcessingParameters SignalProcessing::parametersAdaptive(const SignalProc
 }
 
 
-bool SignalProcessing::checkSignal(const darray &t, const darray &U, const darray &UTintegral, uint channel, double signal, double sigma, double threshold, int increase_point, int decrease_point, double klim, uint signal_point_start)
+bool SignalProcessing::checkSignal(const sarray &U, const sarray &UTintegral, uint channel, double signal, double sigma, double threshold, int increase_point, int decrease_point, double klim, uint signal_point_start)
 {
     //std::cout << sigma << "\n";
     if (signal > 0)
@@ -189,8 +200,8 @@ bool SignalProcessing::checkSignal(const darray &t, const darray &U, const darra
 
                 if (step_increase >= increase_point && step_decrease >= decrease_point) {
                     signal_box[channel*3] = max_signal;
-                    signal_box[channel*3+1] = t[index+impulse_start_point];
-                    signal_box[channel*3+2] = t[index+impulse_end_point];
+                    signal_box[channel*3+1] = timeAxis.at(channel, impulse_start_point);
+                    signal_box[channel*3+2] = timeAxis.at(channel, impulse_end_point);
                     isImpulse = true;
                     break;
                 }
@@ -218,18 +229,20 @@ bool SignalProcessing::checkSignal(const darray &t, const darray &U, const darra
             double N = 0;
             for (uint i = signal_point_start; i < tSize; i++)
             {
-                T += t[index+i];
-                Y += UTintegral[index+i];
-                Y2 += UTintegral[index+i]*UTintegral[index+i];
-                T2 += t[index+i]*t[index+i];
-                TY += t[index+i]*UTintegral[index+i];
+                double ti = timeAxis.at(channel, i);
+                double Yi = UTintegral[index+i];
+                T += ti;
+                Y += Yi;
+                Y2 += Yi*Yi;
+                T2 += ti*ti;
+                TY += ti*Yi;
                 N += 1;
                 //std::cout << t[index+i] << " " << U[index+i] << "\n";
             } 
             //std::cout << "\n";
 
-            double t1 = t[index+signal_point_start];
-            double t2 = t[index+tSize-1];
+            double t1 = timeAxis.at(channel, signal_point_start);
+            double t2 = timeAxis.at(channel, tSize-1);
             double k = (N*TY - T*Y ) / (N*T2-T*T);
             if (std::abs(k*(t2-t1)) > klim*sigma)
                 isImpulse = false;
@@ -242,10 +255,46 @@ bool SignalProcessing::checkSignal(const darray &t, const darray &U, const darra
         return false;
 }
 
-SignalProcessing::SignalProcessing(const darray &t_full, const darray &U_full, uint N_CHANNELS, const parray &parametersArray, const std::vector<std::pair<double, double>> &sigmaCoeff, const barray &work_mask, double coeff_to_energy) : N_CHANNELS(N_CHANNELS),
-                                    signals(N_CHANNELS, 0), signals_sigma(N_CHANNELS, 0.), work_signal(N_CHANNELS, true), shifts(N_CHANNELS, 0.), UTintegrate_full(t_full.size()), t(t_full), UShift(t_full.size()), signal_box(3*N_CHANNELS), parametersArray(parametersArray),
-                                    coeff_to_energy(coeff_to_energy)
+bool SignalProcessing::checkPulse(const sarray &U, uint channel, double signal, const SignalProcessingParameters &parameters)
 {
+    if (!parameters.pulse)
+        return false;
+
+    PulseMatch &match = pulses[channel];
+    match = matchPulse(U.data()+channel*tSize, tSize, *parameters.pulse, timeAxis, channel, detector_buffer);
+
+    if (match.snr < parameters.snr_min || match.amplitude <= 0.)
+        return false;
+
+    signal_box[channel*3] = match.amplitude;
+    signal_box[channel*3+1] = timeAxis.at(channel, match.start);
+    signal_box[channel*3+2] = timeAxis.at(channel, std::min(match.start+parameters.pulse->size(), tSize)-1);
+
+    return signal > 0.;
+}
+
+SignalProcessing::SignalProcessing(const sarray &t_full, const sarray &U_full, uint N_CHANNELS, const parray &parametersArray, const std::vector<std::pair<double, double>> &sigmaCoeff, const barray &work_mask, double coeff_to_energy) : N_CHANNELS(N_CHANNELS),
+                                    tSize(0), coeff_to_energy(coeff_to_energy)
+{
+    assign(t_full, U_full, N_CHANNELS, parametersArray, sigmaCoeff, work_mask, coeff_to_energy);
+}
+
+void SignalProcessing::assign(const sarray &t_full, const sarray &U_full, uint N_CHANNELS, const parray &parametersArray, const std::vector<std::pair<double, double>> &sigmaCoeff, const barray &work_mask, double coeff_to_energy)
+{
+    // assign вместо конструкторов массивов - память остается от прошлого выстрела
+    this->N_CHANNELS = N_CHANNELS;
+    signals.assign(N_CHANNELS, 0.);
+    signals_sigma.assign(N_CHANNELS, 0.);
+    work_signal.assign(N_CHANNELS, true);
+    shifts.assign(N_CHANNELS, 0.);
+    UTintegrate_full.assign(t_full.size(), 0.);
+    timeAxis.assign(t_full, N_CHANNELS);
+    UShift.assign(t_full.size(), 0.);
+    signal_box.assign(3*N_CHANNELS, 0.);
+    pulses.assign(N_CHANNELS, PulseMatch());
+    this->parametersArray = parametersArray;
+    this->coeff_to_energy = coeff_to_energy;
+
     tSize = t_full.size() / N_CHANNELS;
 
     this->parametersArray.resize(N_CHANNELS);
@@ -256,16 +305,19 @@ SignalProcessing::SignalProcessing(const darray &t_full, const darray &U_full, u
 
         if (parameters.signal_point_start == (uint)-1)
         {
-            parameters = parametersAdaptive(parameters, t_full, U_full, i);       
+            parameters = parametersAdaptive(parameters, U_full, i);       
         }
 
-        double shift = findZeroLine(t_full, U_full, i, parameters.step_from_start_zero_line, parameters.step_from_end_zero_line, parameters.start_point_from_start_zero_line, parameters.start_point_from_end_zero_line);
-        integrateSignal(t_full, U_full, i, shift, parameters.point_integrate_start);
+        double shift = findZeroLine(U_full, i, parameters.step_from_start_zero_line, parameters.step_from_end_zero_line, parameters.start_point_from_start_zero_line, parameters.start_point_from_end_zero_line);
+        integrateSignal(U_full, i, shift, parameters.point_integrate_start);
         shiftSignal(U_full, i, shift);
         double signal = countChannelSignal(UTintegrate_full, i, parameters.signal_point_start, parameters.signal_point_step);
         double sigma = countChannelSignalSigma(signal, sigmaCoeff, i);
         //double sigma = 0.;
-        work_signal[i] = checkSignal(t_full, UShift, UTintegrate_full, i, signal, sigma, parameters.threshold, parameters.increase_point, parameters.decrease_point, parameters.klim, parameters.signal_point_start);
+        if (parameters.detector == DETECTOR_MATCHED)
+            work_signal[i] = checkPulse(UShift, i, signal, parameters);
+        else
+            work_signal[i] = checkSignal(UShift, UTintegrate_full, i, signal, sigma, parameters.threshold, parameters.increase_point, parameters.decrease_point, parameters.klim, parameters.signal_point_start);
 
         signals[i] = signal;
         signals_sigma[i] = sigma;
@@ -278,9 +330,28 @@ SignalProcessing::SignalProcessing(const darray &t_full, const darray &U_full, u
 
 }
 
-SignalProcessing::SignalProcessing(const darray &signals, const darray &signals_sigma, const barray &work_signal, double coeff_to_energy) : N_CHANNELS(signals.size()), signals(signals), 
-signals_sigma(signals_sigma), work_signal(work_signal), coeff_to_energy(coeff_to_energy)
+SignalProcessing::SignalProcessing(const darray &signals, const darray &signals_sigma, const barray &work_signal, double coeff_to_energy) : N_CHANNELS(signals.size()),
+tSize(0), coeff_to_energy(coeff_to_energy)
 {
+    assign(signals, signals_sigma, work_signal, coeff_to_energy);
+}
+
+void SignalProcessing::assign(const darray &signals, const darray &signals_sigma, const barray &work_signal, double coeff_to_energy)
+{
+    N_CHANNELS = signals.size();
+    this->signals = signals;
+    this->signals_sigma = signals_sigma;
+    this->work_signal = work_signal;
+    shifts.assign(N_CHANNELS, 0.);
+    UTintegrate_full.clear();
+    timeAxis.clear();
+    UShift.clear();
+    tSize = 0;
+    signal_box.assign(3*N_CHANNELS, 0.);
+    pulses.assign(N_CHANNELS, PulseMatch());
+    parametersArray.assign(N_CHANNELS, SignalProcessingParameters());
+    this->coeff_to_energy = coeff_to_energy;
+
     this->work_signal.resize(N_CHANNELS, true);
     this->signals_sigma.resize(N_CHANNELS, 0);
 
@@ -7,7 +7,7 @@ double SolveEquation::f(double x, const optimize::darray &params) const
 {
     const double a = params[0];
 
-    optimize::darray SArray = countSArray(N_LAMBDA, lMin, dl, a, 1., theta, lambda_reference);
+    optimize::darray SArray = countSArray(band.size, srf.getLambda(band.first), srf.getDl(), a, 1., theta, lambda_reference);
 
-    return convolution(SRF_2, SArray, lMin, lMax) / convolution(SRF_1, SArray, lMin, lMax);
+    return srf.convolution(ch2, SArray.data(), band) / srf.convolution(ch1, SArray.data(), band);
 }
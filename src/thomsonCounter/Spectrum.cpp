@@ -1,4 +1,6 @@
 #include "../../include/thomsonCounter/Spectrum.h"
+#include "../../include/thomsonCounter/FastMath.h"
+#include <algorithm>
 
 #define MEC2 511e3
 
@@ -10,7 +12,7 @@ double SRelative(double A0, double l, double li, double a, double theta)
     double inLi2 = 1./(li*li);
     double SIN = sin(theta / 2.);
     double sin2 = SIN*SIN;
-    double S = A0*exp(- 0.25 * b * b * deltaL*deltaL/sin2*inLi2) * b * (1. - 3.5*deltaL/li + b*b / (4.*li*li*li*sin2) * deltaL*deltaL*deltaL);
+    double S = A0*fastExp(- 0.25 * b * b * deltaL*deltaL/sin2*inLi2, getExpTier()) * b * (1. - 3.5*deltaL/li + b*b / (4.*li*li*li*sin2) * deltaL*deltaL*deltaL);
     
     return S;
 }
@@ -23,7 +25,7 @@ double SClassic(double A0, double l, double li, double a, double theta)
     double inLi2 = 1./(li*li);
     double SIN = sin(theta / 2.);
     double sin2 = SIN*SIN;
-    double S = A0*exp(- 0.25 * b * b * deltaL*deltaL/sin2*inLi2) * b;
+    double S = A0*fastExp(- 0.25 * b * b * deltaL*deltaL/sin2*inLi2, getExpTier()) * b;
     
     return S;
 }
@@ -48,15 +50,54 @@ double convolution(const double * const SRF, const darray &S, double lMin, doubl
     return resultSpectrum;
 }
 
+namespace {
+
+// SRelative во всех точках, постоянные вынесены из цикла, цикл векторизуется вместе с fastExp
+template <uint DEGREE>
+void countSArrayFast(double *S, uint N_LAMBDA, double lMin, double dl, double a, double Aampl, double theta, double li)
+{
+    const double b = 1. / a;
+    const double SIN = sin(theta / 2.);
+    const double sin2 = SIN*SIN;
+    const double k = 0.25 * b * b / (sin2*li*li);
+    const double A = Aampl * b;
+    const double c1 = 3.5 / li;
+    const double c3 = b * b / (4.*li*li*li*sin2);
+
+    for (uint i = 0; i < N_LAMBDA; i++)
+    {
+        double d = lMin + i*dl - li;
+        S[i] = A * fastExp<DEGREE>(-k*d*d) * (1. - c1*d + c3*d*d*d);
+    }
+}
+
+}
+
 darray countSArray(uint N_LAMBDA ,double lMin, double dl, double a, double Aampl, double theta, double lambda_reference) 
 {
     darray SArray(N_LAMBDA);
+    fillSArray(SArray.data(), N_LAMBDA, lMin, dl, a, Aampl, theta, lambda_reference);
+    return SArray;
+}
+
+void fillSArray(double *S, uint N_LAMBDA, double lMin, double dl, double a, double Aampl, double theta, double lambda_reference)
+{
+    ExpTier tier = getExpTier();
+    if (tier == EXP_1E12)
+    {
+        countSArrayFast<EXP_1E12_DEGREE>(S, N_LAMBDA, lMin, dl, a, Aampl, theta, lambda_reference);
+        return;
+    }
+    if (tier == EXP_1E7)
+    {
+        countSArrayFast<EXP_1E7_DEGREE>(S, N_LAMBDA, lMin, dl, a, Aampl, theta, lambda_reference);
+        return;
+    }
 
     for (uint i = 0; i < N_LAMBDA; i++)
     {
-        SArray[i] = SRelative(Aampl, lMin+i*dl, lambda_reference, a, theta);
+        S[i] = SRelative(Aampl, lMin+i*dl, lambda_reference, a, theta);
     }
-    return SArray;
 }
 
 double countA(double Te) 
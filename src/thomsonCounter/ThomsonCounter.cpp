@@ -2,6 +2,7 @@
 #include "thomsonCounter/Solver.h"
 #include "thomsonCounter/SRF.h"
 #include "thomsonCounter/SpectrumRead.h"
+#include "thomsonCounter/ChannelKernels.h"
 #include <utility>
 #include <limits>
 #include <iostream>
@@ -11,26 +12,36 @@
 #define SELECTION_BEST_RATIO 0
 #define SELECTION_RATIO_TO_FIRST_WORK_CHANNEl 1
 
+#define FIXED_N_CHANNELS 8 // число каналов спектрометров в main.cpp, для него ядра по парам с N при компиляции
+
 void ThomsonCounter::createChannelsNumberArray()
 {
-    N_RATIO = N_CHANNELS*(N_CHANNELS-1)/2;
-    channels_number.reserve(N_RATIO);
-    for (uint i = 0; i < N_CHANNELS*N_CHANNELS; i++)
-    {
-        uint ch1 = i % N_CHANNELS;
-        uint ch2 = (i-ch1) / N_CHANNELS;
-        if (ch2 > ch1)
-            channels_number.emplace_back(ch1, ch2);   
-    }
+    channel_pairs = &ChannelPairs::get(N_CHANNELS);
+    N_RATIO = channel_pairs->getNRatio();
+    ratio_index.assign(N_RATIO, -1);
 }
 
 double ThomsonCounter::findTZeroApproximation() const
 {
+    if (!response)
+        return findTZeroApproximation(SCount, N_TEMPERATURE, T0, dT);
+
+    // узлы таблицы неравномерны по Te, ищется номер узла
+    darray S;
+    response->slice(theta, S);
+    return response->getNodeT(findTZeroApproximation(S, response->getNT(), 0., 1.));
+}
+
+double ThomsonCounter::findTZeroApproximation(const darray &S, uint N_T, double T0, double dT) const
+{
+    if (N_CHANNELS == FIXED_N_CHANNELS)
+        return findTZeroApproximationFixed<FIXED_N_CHANNELS>(signal, channel_work, S, N_T, T0, dT);
+
     const double maxD = std::numeric_limits<double>::max();  
     double Te0 = T0;
 
     double L_2_min = maxD;
-    for (uint it = 0; it < N_TEMPERATURE; it++)
+    for (uint it = 0; it < N_T; it++)
     {
         double L2 = 0.;
 
@@ -42,7 +53,7 @@ double ThomsonCounter::findTZeroApproximation() const
             if (!(channel_work[ch1]&&channel_work[ch2]))
                 continue;
 
-            double delta = signal[ch2]/signal[ch1] - getSCount(it, ch2)/getSCount(it, ch1);
+            double delta = signal[ch2]/signal[ch1] - S[it+ch2*N_T]/S[it+ch1*N_T];
 
 
             L2 += delta*delta;
@@ -67,17 +78,54 @@ double ThomsonCounter::findTZeroApproximation() const
 double ThomsonCounter::devFij(uint ch1, uint ch2, double Tij) const
 {
     const double deltaT = 1.;
-    darray SArray_1 = countSArray(N_LAMBDA, lMin, dl, countA(Tij), SNorma(lambda_reference, theta), theta, lambda_reference);
-    darray SArray_2 = countSArray(N_LAMBDA, lMin, dl, countA(Tij+deltaT), SNorma(lambda_reference, theta), theta, lambda_reference);
+    if (isResponse(Tij) && isResponse(Tij+deltaT))
+    {
+        darray Q1(N_CHANNELS);
+        darray Q2(N_CHANNELS);
+        response->count(Tij, theta, Q1.data());
+        response->count(Tij+deltaT, theta, Q2.data());
+        return (Q2[ch2]/Q2[ch1] - Q1[ch2]/Q1[ch1]) / deltaT;
+    }
+
+    SRFBand band = srf_bands.getUnion(ch1, ch2);
+    darray SArray_1 = countSBand(band, Tij, SNorma(lambda_reference, theta));
+    darray SArray_2 = countSBand(band, Tij+deltaT, SNorma(lambda_reference, theta));
 
 
-    double dev_ratio_count = convolution(getSRFch(ch2), SArray_2, lMin, lMax) / convolution(getSRFch(ch1), SArray_2, lMin, lMax);
-    dev_ratio_count -= convolution(getSRFch(ch2), SArray_1, lMin, lMax) / convolution(getSRFch(ch1), SArray_1, lMin, lMax);
+    double dev_ratio_count = srf_bands.convolution(ch2, SArray_2.data(), band) / srf_bands.convolution(ch1, SArray_2.data(), band);
+    dev_ratio_count -= srf_bands.convolution(ch2, SArray_1.data(), band) / srf_bands.convolution(ch1, SArray_1.data(), band);
     dev_ratio_count /= deltaT;
 
     return dev_ratio_count;
 }
 
+template <uint N>
+void ThomsonCounter::devFPairs(double Tij, std::array<double, N*(N-1)/2> &dev) const
+{
+    const double deltaT = 1.; // как в devFij
+    std::array <double, N> Q1;
+    std::array <double, N> Q2;
+    if (isResponse(Tij) && isResponse(Tij+deltaT))
+    {
+        response->count(Tij, theta, Q1.data());
+        response->count(Tij+deltaT, theta, Q2.data());
+        devFPairsFixed<N>(Q1, Q2, deltaT, dev);
+        return;
+    }
+
+    const SRFBand &band = srf_bands.getUnion();
+    darray SArray_1 = countSBand(band, Tij, SNorma(lambda_reference, theta));
+    darray SArray_2 = countSBand(band, Tij+deltaT, SNorma(lambda_reference, theta));
+
+    for (uint ch = 0; ch < N; ch++)
+    {
+        Q1[ch] = srf_bands.convolution(ch, SArray_1.data(), band);
+        Q2[ch] = srf_bands.convolution(ch, SArray_2.data(), band);
+    }
+
+    devFPairsFixed<N>(Q1, Q2, deltaT, dev);
+}
+
 // double ThomsonCounter::devFij_zero(uint ch1, uint ch2, double T) const
 // {
 //     uint it = (T-T0)/dT;
@@ -86,10 +134,23 @@ double ThomsonCounter::devFij(uint ch1, uint ch2, double Tij) const
 //     return devTij_zero;
 // }
 
+darray ThomsonCounter::countSBand(const SRFBand &band, double Te, double Aampl) const
+{
+    return countSArray(band.size, lMin + band.first*dl, dl, countA(Te), Aampl, theta, lambda_reference);
+}
+
 double ThomsonCounter::countTij(uint ch1, uint ch2)
 {
     double ratio_signal = signal[ch2] / signal[ch1];
-    SolveEquation solver(ratio_signal, getSRFch(ch1), getSRFch(ch2), lMin, lMax, theta, lambda_reference, N_LAMBDA, iter_limit);
+    if (response)
+    {
+        bool success = false;
+        double T = response->solveRatio(ch1, ch2, ratio_signal, theta, Te0, epsilon, iter_limit, success);
+        work = success;
+        return T;
+    }
+
+    SolveEquation solver(ratio_signal, srf_bands, ch1, ch2, theta, lambda_reference, iter_limit);
     solver.set_optimizer_parameters(alpha);
     double T = solver.solveT(Te0, epsilon);
     work = solver.is_optimize_success();
@@ -117,46 +178,37 @@ double ThomsonCounter::countSigmaTij(uint ch1, uint ch2, double devTij) const
 
 double ThomsonCounter::cov(uint k, uint ks) const
 {
-    uint k0 = number_ratio[k];
-    uint ks0 = number_ratio[ks];
-    uint ch1_1 = channels_number[k0].first;
-    uint ch2_1 = channels_number[k0].second;
+    // общий канал пар из таблицы ChannelPairs: cov = dTk/da * dTks/da * sigma_a^2
+    PairShare share = channel_pairs->getShare(number_ratio[k], number_ratio[ks]);
 
-    uint ch1_2 = channels_number[ks0].first;
-    uint ch2_2 = channels_number[ks0].second;
-    
-    int number_equal_index = delta(ch1_1, ch1_2) + delta(ch1_1, ch2_2) + delta(ch2_1, ch1_2) + delta(ch2_1, ch2_2);
-    
-    if (number_equal_index == 0)
+    if (share.first < 0)
         return 0;
-    else if (number_equal_index == 1)
+    if (share.first == 2)
+        return sigmaTijArray[k];
+
+    const std::pair<uint, uint> &pair = channel_pairs->getPair(number_ratio[k]);
+    uint ch = share.first == 0 ? pair.first : pair.second;
+    return gradient[2*k+share.first] * gradient[2*ks+share.second] * signal_error[ch]*signal_error[ch];
+}
+
+void ThomsonCounter::createCovariance()
+{
+    const uint size = number_ratio.size();
+
+    gradient.resize(2*size);
+    for (uint k = 0; k < size; k++)
     {
-        double a_1_1 = signal[ch1_1];
-        double a_2_1 = signal[ch2_1];
-    
-        double a_1_2 = signal[ch1_2];
-        double a_2_2 = signal[ch2_2];
-    
-        double devTk = devTijArray[k];
-        double devTks = devTijArray[ks];
-    
-        if (ch2_1 == ch2_2)
-        {
-            return 1. / (devTk*devTks*a_1_1*a_1_2)*signal_error[ch2_1]*signal_error[ch2_1];
-        }
-        else if (ch2_1 == ch1_2) 
-        {
-            return -a_2_2 / (devTk*devTks*a_1_1*a_1_2*a_1_2) * signal_error[ch2_1]*signal_error[ch2_1];
-        }
-        else if (ch1_1 == ch2_2)
-        {
-            return -a_2_1 / (devTk*devTks*a_1_1*a_1_1*a_1_2) * signal_error[ch1_1]*signal_error[ch1_1];
-        }
-        else
-            return a_2_1*a_2_2 / (devTk*devTks*a_1_1*a_1_1*a_1_2*a_1_2) * signal_error[ch1_1]*signal_error[ch1_1];
+        const std::pair<uint, uint> &pair = channel_pairs->getPair(number_ratio[k]);
+        double a1 = signal[pair.first];
+        double a2 = signal[pair.second];
+        gradient[2*k] = -a2 / (devTijArray[k]*a1*a1);
+        gradient[2*k+1] = 1. / (devTijArray[k]*a1);
     }
-    else 
-        return sigmaTijArray[k];
+
+    covariance.assign(size*size, 0.);
+    for (uint k = 0; k < size; k++)
+        for (uint j = 0; j < k; j++)
+            covariance[j+k*size] = cov(k, j);
 }
 
 void ThomsonCounter::createWeight()
@@ -197,17 +249,17 @@ double ThomsonCounter::countWeightErrorT() const
         W += wij;
     }
 
+    // квадратичная форма по нижнему треугольнику covariance
+    const uint size = weight.size();
     double sigma2 = 0;
 
-    for (uint i = 0; i < weight.size(); i++)
+    for (uint i = 0; i < size; i++)
     {
+        const double *row = covariance.data()+i*size;
+        double sum = 0.;
         for (uint j = 0; j < i; j++)
-        {
-            double wk = weight[i];
-            double wks = weight[j];
-
-            sigma2 += wk*wks*cov(i, j);
-        }
+            sum += row[j]*weight[j];
+        sigma2 += weight[i]*sum;
     }
 
     sigma2 *= 2./(W*W);
@@ -219,15 +271,8 @@ double ThomsonCounter::countWeightErrorT() const
 
 int ThomsonCounter::findRatioNumber(uint ch1, uint ch2) const
 {
-    for (uint i = 0; i < N_RATIO; i++)
-    {
-        uint ch_1 = channels_number[i].first;
-        uint ch_2 = channels_number[i].second;
-
-        if (ch_1 == ch1 && ch_2 == ch2)
-            return i;
-    }
-    return -1;
+    int k = channel_pairs->find(ch1, ch2);
+    return k < 0 ? -1 : ratio_index[k];
 }
 
 ThomsonCounter::ThomsonCounter(uint N_CHANNELS,
@@ -235,17 +280,65 @@ ThomsonCounter::ThomsonCounter(uint N_CHANNELS,
                                const darray &signal, const darray &signal_error, double theta, const darray &Ki, const darray &sigmaKi,
                                double energy, double sigmaEnergy, double time_point, double x_positon,
                                const barray &channel_work, 
-                               double lambda_reference, int selectionMethod) : selectionMethod(selectionMethod),
-                               lim_percent(0.5), work(false), N_CHANNELS(N_CHANNELS), signal(signal), signal_error(signal_error), channel_work(channel_work),
-                               theta(theta), lambda_reference(lambda_reference), Ki(Ki), sigmaKi(sigmaKi),
-                               TResult(0.), t_error(0.), neResult(0.), ne_error(0.),
-                               rmse(0.), rmsePlus(0.), rmseMinus(0.),
-                               energy(energy), sigmaEnergy(sigmaEnergy),
-                               time_point(time_point), x_positon(x_positon)
+                               double lambda_reference, int selectionMethod) : lim_percent(0.5), N_CHANNELS(0)
+
+{
+    assign(N_CHANNELS, srf_file_name, convolution_file_name, signal, signal_error, theta, Ki, sigmaKi, energy, sigmaEnergy, time_point, x_positon,
+           channel_work, lambda_reference, selectionMethod);
+}
 
+void ThomsonCounter::assign(uint N_CHANNELS,
+                            const std::string &srf_file_name, const std::string &convolution_file_name,
+                            const darray &signal, const darray &signal_error, double theta, const darray &Ki, const darray &sigmaKi,
+                            double energy, double sigmaEnergy, double time_point, double x_positon,
+                            const barray &channel_work,
+                            double lambda_reference, int selectionMethod)
 {
-    readSRF(srf_file_name, SRF, lMin, lMax, dl, N_LAMBDA, N_CHANNELS);
-    readSpectrumFromT(convolution_file_name, T0, dT, N_TEMPERATURE, SCount, N_CHANNELS);
+    // таблицы те же для всех страниц спектрометра, повторно файлы не читаются
+    bool readSRFFile = SRF.empty() || N_CHANNELS != this->N_CHANNELS || srf_file_name != this->srf_file_name;
+    bool readConvolutionFile = SCount.empty() || N_CHANNELS != this->N_CHANNELS || convolution_file_name != this->convolution_file_name;
+
+    this->selectionMethod = selectionMethod;
+    work = false;
+    this->N_CHANNELS = N_CHANNELS;
+    this->signal = signal;
+    this->signal_error = signal_error;
+    this->channel_work = channel_work;
+    this->theta = theta;
+    this->lambda_reference = lambda_reference;
+    this->Ki = Ki;
+    this->sigmaKi = sigmaKi;
+    TResult = 0.;
+    t_error = 0.;
+    neResult = 0.;
+    ne_error = 0.;
+    rmse = 0.;
+    rmsePlus = 0.;
+    rmseMinus = 0.;
+    this->energy = energy;
+    this->sigmaEnergy = sigmaEnergy;
+    this->time_point = time_point;
+    this->x_positon = x_positon;
+
+    response.reset();
+    TijArray.clear();
+    sigmaTijArray.clear();
+    devTijArray.clear();
+    number_ratio.clear();
+    weight.clear();
+
+    if (readSRFFile)
+    {
+        readSRF(srf_file_name, SRF, lMin, lMax, dl, N_LAMBDA, N_CHANNELS);
+        srf_bands.assign(SRF, N_CHANNELS, N_LAMBDA, lMin, lMax);
+        this->srf_file_name = srf_file_name;
+    }
+    if (readConvolutionFile)
+    {
+        readSpectrumFromT(convolution_file_name, T0, dT, N_TEMPERATURE, SCount, N_CHANNELS);
+        this->convolution_file_name = convolution_file_name;
+        convolution_table.reset();
+    }
     work = true;
 
     // if (!work)
@@ -286,9 +379,9 @@ ThomsonCounter::ThomsonCounter(uint N_CHANNELS,
             normalizeChannel = index;
     }
 
-    signalResult.resize(N_CHANNELS, 0);
-    signalResultMinus.resize(N_CHANNELS, 0);
-    signalResultPlus.resize(N_CHANNELS, 0);
+    signalResult.assign(N_CHANNELS, 0);
+    signalResultMinus.assign(N_CHANNELS, 0);
+    signalResultPlus.assign(N_CHANNELS, 0);
 
     // if (work) {
     createChannelsNumberArray();
@@ -296,6 +389,32 @@ ThomsonCounter::ThomsonCounter(uint N_CHANNELS,
     //}
 }
 
+void ThomsonCounter::setResponseTable(const std::shared_ptr<const ResponseTable> &response)
+{
+    // таблица другого спектрометра или theta вне сетки - спектры считаются как без таблицы
+    bool fit = response && response->getNChannels() == N_CHANNELS && response->contains(response->getGrid().TMin, theta) &&
+               response->getLambdaReference() == lambda_reference;
+    std::shared_ptr <const ResponseTable> use = fit ? response : nullptr;
+    if (use == this->response)
+        return;
+
+    this->response = use;
+    Te0 = findTZeroApproximation();
+}
+
+void ThomsonCounter::setConvolution(const std::shared_ptr<const ConvolutionTable> &table)
+{
+    if (!table || table == convolution_table || table->getNChannels() != N_CHANNELS)
+        return;
+
+    convolution_table = table;
+    T0 = table->getGrid().T0;
+    dT = table->getGrid().dT;
+    N_TEMPERATURE = table->getGrid().N_T;
+    SCount = table->getSCount();
+    Te0 = findTZeroApproximation();
+}
+
 ThomsonCounter::ThomsonCounter(uint N_CHANNELS, const std::string &srf_file_name, const std::string &convolution_file_name, const SignalProcessing &sp, double theta, const darray &Ki, const darray &sigmaKi,
                                 double energy, double sigmaEnergy, double time_point, double x_position,
                                 double lambda_reference, int selectionMethod) :
@@ -305,6 +424,15 @@ ThomsonCounter::ThomsonCounter(uint N_CHANNELS, const std::string &srf_file_name
 {
 }
 
+void ThomsonCounter::assign(uint N_CHANNELS, const std::string &srf_file_name, const std::string &convolution_file_name, const SignalProcessing &sp, double theta, const darray &Ki, const darray &sigmaKi,
+                            double energy, double sigmaEnergy, double time_point, double x_position,
+                            double lambda_reference, int selectionMethod)
+{
+    assign(N_CHANNELS, srf_file_name, convolution_file_name, sp.getSignals(), sp.getSignalsSigma(), theta, Ki,
+           sigmaKi, energy, sigmaEnergy, time_point, x_position,
+           sp.getWorkSignals(), lambda_reference, selectionMethod);
+}
+
 bool ThomsonCounter::isChannelUseToCount(uint ch1, uint ch2, const barray &is_channel_use) const 
 {
     if (selectionMethod == SELECTION_BEST_RATIO)
@@ -368,8 +496,14 @@ bool ThomsonCounter::count(const double alpha, const uint iter_limit, const doub
     //use_ratio.reserve(N_RATIO_WORK);
 
     {
+        // при FIXED_N_CHANNELS производные всех пар при Te0 считаются сразу, 2*N сверток вместо 4 на пару
+        std::array <double, FIXED_N_CHANNELS*(FIXED_N_CHANNELS-1)/2> devFixed;
+        bool fixed = N_CHANNELS == FIXED_N_CHANNELS;
+        if (fixed)
+            devFPairs<FIXED_N_CHANNELS>(Te0, devFixed);
+
         uint index_ratio = 0;
-        for (const auto &it : channels_number)
+        for (const auto &it : channel_pairs->getPairs())
         {
             index_ratio++;
             uint ch1 = it.first;
@@ -377,7 +511,7 @@ bool ThomsonCounter::count(const double alpha, const uint iter_limit, const doub
 
             if (!(channel_work[ch1] && channel_work[ch2])) continue;
 
-            double devTij_zero = devFij(ch1, ch2, Te0);
+            double devTij_zero = fixed ? devFixed[index_ratio-1] : devFij(ch1, ch2, Te0);
             double sigmaTij_zero = countSigmaTij(ch1, ch2, devTij_zero);
 
             if (sigmaTij_zero / Te0 < lim_percent) {
@@ -399,8 +533,8 @@ bool ThomsonCounter::count(const double alpha, const uint iter_limit, const doub
         uint step_count = 0;
         for (const auto &it : devTijZeroArray)
         {
-            uint ch1 = channels_number[it.first].first;
-            uint ch2 = channels_number[it.first].second;
+            uint ch1 = channel_pairs->getPair(it.first).first;
+            uint ch2 = channel_pairs->getPair(it.first).second;
             if (isChannelUseToCount(ch1, ch2, is_channel_use))
             {
                 if (!is_channel_use[ch1])
@@ -419,6 +553,7 @@ bool ThomsonCounter::count(const double alpha, const uint iter_limit, const doub
                 devTijArray.push_back(devTij);
                 sigmaTijArray.push_back(sigmaTij);
                 number_ratio.push_back(it.first);
+                ratio_index[it.first] = TijArray.size()-1;
 
                 step_count++;
                 //use_ratio.push_back(it.first);
@@ -430,6 +565,7 @@ bool ThomsonCounter::count(const double alpha, const uint iter_limit, const doub
 
     {
         createWeight();
+        createCovariance();
         TResult = countWeightT();
         t_error = countWeightErrorT();
 
@@ -459,8 +595,29 @@ bool ThomsonCounter::countConcentration(double Te)
     double TeError  = getTError();
     double dT = 1e-8;
 
-    darray SResult = countSArray(N_LAMBDA, lMin, dl, countA(Te), SNorma(lambda_reference, theta), theta, lambda_reference);
-    darray SResult_dT = countSArray(N_LAMBDA, lMin, dl, countA(Te+dT), SNorma(lambda_reference, theta), theta, lambda_reference);
+    // свертки каналов при Te и их производные (Q(Te)-Q(Te+dT))/dT
+    darray Q(N_CHANNELS, 0.);
+    darray devQ(N_CHANNELS, 0.);
+    if (isResponse(Te))
+    {
+        response->count(Te, theta, Q.data(), devQ.data());
+        for (double &value : devQ)
+            value = -value;
+    }
+    else
+    {
+        const SRFBand &band = srf_bands.getUnion();
+        darray SResult = countSBand(band, Te, SNorma(lambda_reference, theta));
+        darray SResult_dT = countSBand(band, Te+dT, SNorma(lambda_reference, theta));
+        for (uint i = 0; i < N_CHANNELS; i++)
+        {
+            if (channel_work[i])
+            {
+                Q[i] = srf_bands.convolution(i, SResult.data(), band);
+                devQ[i] = (Q[i] - srf_bands.convolution(i, SResult_dT.data(), band))/dT;
+            }
+        }
+    }
 
     //double max_signal = 0;
 
@@ -471,8 +628,7 @@ bool ThomsonCounter::countConcentration(double Te)
     {
         if (channel_work[i])
         {
-            double Qi = convolution(getSRFch(i), SResult, lMin, lMax);
-            double Qi_dT = convolution(getSRFch(i), SResult_dT, lMin, lMax);
+            double Qi = Q[i];
 
             double ai = signal[i];
             double dai = signal_error[i];
@@ -485,8 +641,8 @@ bool ThomsonCounter::countConcentration(double Te)
                 double W_T = 0;
                 for (uint m = 0; m < weight.size(); m++)
                 {
-                    uint k = channels_number[number_ratio[m]].first;
-                    uint l = channels_number[number_ratio[m]].second;
+                    uint k = channel_pairs->getPair(number_ratio[m]).first;
+                    uint l = channel_pairs->getPair(number_ratio[m]).second;
 
                     W_T += weight[m];
 
@@ -507,7 +663,7 @@ bool ThomsonCounter::countConcentration(double Te)
             }*/
 
 
-            double devQi = (Qi-Qi_dT)/dT;
+            double devQi = devQ[i];
             double dQi = TeError * devQi;
             
             double covFTeAi = dai*dai*devQi*devT_ai; // нужно учесть корреляцию
@@ -628,19 +784,50 @@ bool ThomsonCounter::countSignalResult()
     return true;
 }
 
+void ThomsonCounter::setResult(double Te, double TeError, double ne, double neError, double rmse, double rmsePlus, double rmseMinus,
+                               const darray &signalResult, const darray &signalResultPlus, const darray &signalResultMinus)
+{
+    TResult = Te;
+    t_error = TeError;
+    neResult = ne;
+    ne_error = neError;
+    this->rmse = rmse;
+    this->rmsePlus = rmsePlus;
+    this->rmseMinus = rmseMinus;
+
+    this->signalResult = signalResult;
+    this->signalResultPlus = signalResultPlus;
+    this->signalResultMinus = signalResultMinus;
+    this->signalResult.resize(N_CHANNELS, 0.);
+    this->signalResultPlus.resize(N_CHANNELS, 0.);
+    this->signalResultMinus.resize(N_CHANNELS, 0.);
+}
+
 darray ThomsonCounter::countSyntheticSignal(double Te, double ne, bool all) const
 {
     if (Te == 0 || std::isnan(Te) || ne == 0 || std::isnan(ne))
         return darray(N_CHANNELS, 0.);
 
-    darray S = countSArray(N_LAMBDA, lMin, dl, countA(Te), ne*energy*SNorma(lambda_reference, theta), theta, lambda_reference);
     darray synthcetic_signal(N_CHANNELS, 0.);
 
+    if (isResponse(Te))
+    {
+        darray Q(N_CHANNELS);
+        response->count(Te, theta, Q.data());
+        for (uint ch = 0; ch < N_CHANNELS; ch++)
+            if (channel_work[ch] || all)
+                synthcetic_signal[ch] = ne*energy*Q[ch]/Ki[ch];
+        return synthcetic_signal;
+    }
+
+    const SRFBand &band = srf_bands.getUnion();
+    darray S = countSBand(band, Te, ne*energy*SNorma(lambda_reference, theta));
+
     for (uint ch = 0; ch < N_CHANNELS; ch++)
     {
         if (channel_work[ch] || all)
         {
-            synthcetic_signal[ch] = convolution(getSRFch(ch), S, lMin, lMax)/Ki[ch];
+            synthcetic_signal[ch] = srf_bands.convolution(ch, S.data(), band)/Ki[ch];
         }
     }
 
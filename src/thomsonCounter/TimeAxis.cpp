@@ -0,0 +1,83 @@
+#include "thomsonCounter/TimeAxis.h"
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+bool TimeAxis::findUniform(const sarray &t_full, uint channel, double &t0, double &dt) const
+{
+    const sample_t *x = t_full.data()+channel*tSize;
+    t0 = tSize > 0 ? x[0] : 0.;
+    dt = tSize > 1 ? ((double) x[tSize-1] - x[0]) / (tSize-1) : 0.;
+
+    // отклонение от сетки меньше 1e-6 шага или точности хранения времени
+    double tmax = std::max(std::abs(t0), std::abs(t0 + (tSize > 0 ? tSize-1 : 0)*dt));
+    double tolerance = 1e-6*std::abs(dt) + 4.*std::numeric_limits<sample_t>::epsilon()*tmax;
+
+    for (uint i = 0; i < tSize; i++)
+        if (std::abs(x[i] - (t0 + i*dt)) > tolerance)
+            return false;
+
+    return true;
+}
+
+void TimeAxis::assign(const sarray &t_full, uint N_CHANNELS)
+{
+    this->N_CHANNELS = N_CHANNELS;
+    tSize = N_CHANNELS > 0 ? t_full.size() / N_CHANNELS : 0;
+    t0.assign(N_CHANNELS, 0.);
+    dt.assign(N_CHANNELS, 0.);
+
+    uniform = true;
+    for (uint ch = 0; ch < N_CHANNELS && uniform; ch++)
+        uniform = findUniform(t_full, ch, t0[ch], dt[ch]);
+
+    if (uniform)
+        t.clear();
+    else
+        t.assign(t_full.begin(), t_full.begin()+N_CHANNELS*tSize);
+}
+
+void TimeAxis::clear()
+{
+    N_CHANNELS = 0;
+    tSize = 0;
+    uniform = true;
+    t0.clear();
+    dt.clear();
+    t.clear();
+}
+
+uint TimeAxis::lowerBound(uint channel, double time) const
+{
+    if (!uniform)
+    {
+        for (uint i = 0; i < tSize; i++)
+            if (t[channel*tSize+i] >= time)
+                return i;
+        return tSize;
+    }
+
+    if (dt[channel] <= 0.)
+        return t0[channel] >= time ? 0 : tSize;
+
+    // индекс по сетке, затем поправка на округление на границе
+    double x = std::ceil((time - t0[channel]) / dt[channel]);
+    uint i = x <= 0. ? 0 : (x >= tSize ? tSize : (uint) x);
+    while (i > 0 && at(channel, i-1) >= time)
+        i--;
+    while (i < tSize && at(channel, i) < time)
+        i++;
+    return i;
+}
+
+sarray TimeAxis::toArray() const
+{
+    if (!uniform)
+        return t;
+
+    sarray t_full(N_CHANNELS*tSize);
+    for (uint ch = 0; ch < N_CHANNELS; ch++)
+        for (uint i = 0; i < tSize; i++)
+            t_full[ch*tSize+i] = at(ch, i);
+    return t_full;
+}